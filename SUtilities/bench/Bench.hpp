@@ -0,0 +1,32 @@
+#pragma once
+#ifndef _BENCH_H
+#define _BENCH_H
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+/**
+ * Minimal timing helpers shared by the benchmarks
+ * Build with optimizations (ie. CMAKE_BUILD_TYPE=Release) for meaningful results
+ */
+namespace Bench {
+	/// results are accumulated here so the compiler can't discard the measured work
+	inline volatile std::uint64_t sink = 0;
+
+	/**
+	 * Runs op(i) for i in [0, iterations) and returns the average time per call in nanoseconds
+	 */
+	template<typename Op>
+	double nsPerOp(std::uint64_t iterations, Op&& op) {
+		const auto start = std::chrono::steady_clock::now();
+		for (std::uint64_t i = 0; i < iterations; ++i) {
+			op(i);
+		}
+		const auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(iterations);
+	}
+
+	inline void report(const char* name, double ns) {
+		std::printf("%-40s %10.2f ns/op\n", name, ns);
+	}
+}
+#endif
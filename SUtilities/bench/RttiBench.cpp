@@ -0,0 +1,73 @@
+#include "Bench.hpp"
+#include <MultiVisitor.hpp>
+#include <TypeList.hpp>
+#include <Visitable.hpp>
+#include <Visitor.hpp>
+#include <VisitorAlgorithms.hpp>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace SUtil;
+
+// Built twice, as RttiBench and NoRttiBench (-fno-rtti), compare the output of both
+// The default dispatch policy is DynamicCast with RTTI and Table without
+constexpr std::size_t nodeCount = 1 << 16;
+constexpr std::uint64_t passes = 200;
+
+using NodeBase = BaseVisitable<int>;
+
+struct NodeA : public NodeBase { int v = 1; MAKE_VISITABLE(int); };
+struct NodeB : public NodeBase { int v = 2; MAKE_VISITABLE(int); };
+struct NodeC : public NodeBase { int v = 3; MAKE_VISITABLE(int); };
+struct NodeD : public NodeBase { int v = 4; MAKE_VISITABLE(int); };
+struct NodeVisitor : public Visitor<int, NodeA, NodeB, NodeC, NodeD> {
+	int visit(NodeA& n) override { return n.v; }
+	int visit(NodeB& n) override { return n.v * 2; }
+	int visit(NodeC& n) override { return n.v + 7; }
+	int visit(NodeD& n) override { return n.v ^ 5; }
+};
+
+struct Combine {
+	int visit(NodeA& a, NodeB& b) { return a.v + b.v; }
+	int visit(NodeA& a, NodeA& b) { return a.v - b.v; }
+	int visit(NodeC& a, NodeD& b) { return a.v * b.v; }
+};
+using Nodes = TL::TypeList<NodeA, NodeB, NodeC, NodeD>;
+using Combiner = MultiVisitor<int, Nodes, Nodes, MultiDispatch::symmetric, DefaultConstructUnknownPolicy>;
+
+std::vector<std::unique_ptr<NodeBase>> makeNodes() {
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int> type(0, 3);
+	std::vector<std::unique_ptr<NodeBase>> nodes;
+	nodes.reserve(nodeCount);
+	for (std::size_t i = 0; i < nodeCount; ++i) {
+		switch (type(rng)) {
+		case 0: nodes.emplace_back(std::make_unique<NodeA>()); break;
+		case 1: nodes.emplace_back(std::make_unique<NodeB>()); break;
+		case 2: nodes.emplace_back(std::make_unique<NodeC>()); break;
+		default: nodes.emplace_back(std::make_unique<NodeD>()); break;
+		}
+	}
+	return nodes;
+}
+
+int main(int, char** argv) {
+	std::printf("RTTI %s, binary size %ju bytes\n", SUTIL_RTTI ? "enabled" : "disabled",
+		static_cast<std::uintmax_t>(std::filesystem::file_size(argv[0])));
+	auto nodes = makeNodes();
+	NodeVisitor visitor;
+	Bench::report("accept (default dispatch policy)", Bench::nsPerOp(passes * nodeCount, [&](std::uint64_t i) {
+		Bench::sink = Bench::sink + nodes[i % nodeCount]->accept(visitor);
+	}));
+	Bench::report("acceptAll (grouped)", Bench::nsPerOp(passes, [&](std::uint64_t) {
+		Bench::sink = Bench::sink + acceptAll(nodes, visitor, 0, std::plus<int>{});
+	}) / nodeCount);
+	Combine combine;
+	Bench::report("MultiVisitor", Bench::nsPerOp(passes * nodeCount, [&](std::uint64_t i) {
+		Bench::sink = Bench::sink + Combiner::dispatch(combine, *nodes[i % nodeCount], *nodes[(i + 1) % nodeCount]);
+	}));
+	return 0;
+}
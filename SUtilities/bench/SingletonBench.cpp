@@ -0,0 +1,155 @@
+#include "Bench.hpp"
+#include <Singleton.hpp>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace SUtil;
+
+// Scheduling and running the destruction of many singletons with a LongevityDestructionPolicy,
+// then threads hammering get() on a singleton that already exists
+// Only the fast path of get() is measured, the locking policy is only used by the first get()
+// Then the access policies under a read mostly workload from 1 to 64 threads
+constexpr std::uint64_t callsPerThread = 1 << 24;
+
+struct Counter {
+	std::uint64_t value = 1;
+};
+
+template<int tag>
+struct Tagged : Counter {};
+
+using NoLock = Singleton<Tagged<0>>;
+using Mutex = MTSingleton_t<Tagged<1>>;
+using Futex = Singleton<Tagged<2>, ErrorDeadRefPolicy, FreeStoreCreatePolicy,
+	StandardDestructionPolicy, SingletonFutexLock>;
+using Once = OnceSingleton_t<Tagged<3>>;
+using Static = Singleton<Tagged<4>, ErrorDeadRefPolicy, StaticStorageCreatePolicy>;
+using Constant = Singleton<Tagged<5>, ErrorDeadRefPolicy, ConstantInitCreatePolicy>;
+
+Counter* volatile rawPointer = new Counter();
+
+constexpr std::uint64_t lifetimeSingletons = 100000;
+
+/**
+ * Schedules many destructions with a LongevityDestructionPolicy, they are all run by one atexit handler
+ */
+void scheduleLifetimes() {
+	static std::uint64_t destroyed = 0;
+	const auto schedule = [](std::uint64_t i) {
+		switch (i % 4) {
+		case 0: LongevityDestructionPolicy<10>::scheduleDestruction([]() noexcept { ++destroyed; }); break;
+		case 1: LongevityDestructionPolicy<500>::scheduleDestruction([]() noexcept { ++destroyed; }); break;
+		case 2: LongevityDestructionPolicy<20>::scheduleDestruction([]() noexcept { ++destroyed; }); break;
+		default: LongevityDestructionPolicy<1000>::scheduleDestruction([]() noexcept { ++destroyed; }); break;
+		}
+	};
+	Bench::report("schedule longevity", Bench::nsPerOp(lifetimeSingletons, schedule));
+	reserveLifetimeSingletons(lifetimeSingletons * 2);
+	Bench::report("schedule longevity (reserved)", Bench::nsPerOp(lifetimeSingletons, schedule));
+	const auto start = std::chrono::steady_clock::now();
+	SingletonLongevityTracker::destroyAll();
+	const auto end = std::chrono::steady_clock::now();
+	Bench::report("destroy longevity", std::chrono::duration<double, std::nano>(end - start).count()
+		/ static_cast<double>(lifetimeSingletons * 2));
+	Bench::sink = Bench::sink + destroyed;
+}
+
+/**
+ * @return the average time of a call of op, over all threads
+ */
+template<typename Op>
+double contended(unsigned threads, Op op, std::uint64_t calls = callsPerThread) {
+	std::atomic<unsigned> ready{ 0 };
+	std::vector<double> times(threads);
+	std::vector<std::thread> workers;
+	for (unsigned t = 0; t < threads; ++t) {
+		workers.emplace_back([&, t]() {
+			++ready;
+			while (ready.load() < threads) {}
+			std::uint64_t sum = 0;
+			times[t] = Bench::nsPerOp(calls, [&](std::uint64_t i) { sum += op(i); });
+			Bench::sink = Bench::sink + sum;
+		});
+	}
+	for (auto& worker : workers)
+		worker.join();
+	return *std::max_element(times.begin(), times.end());
+}
+
+struct Stats {
+	std::uint64_t hits = 0;
+	std::uint64_t misses = 0;
+};
+
+template<template<typename> typename access>
+using Accessed = Singleton<Stats, ErrorDeadRefPolicy, FreeStoreCreatePolicy,
+	StandardDestructionPolicy, SingletonLockGuard, access>;
+
+constexpr std::uint64_t accessesPerThread = 1 << 18;
+/// one access in writeEvery is a write
+constexpr std::uint64_t writeEvery = 64;
+
+/**
+ * A read mostly workload on a singleton with the access policy, read with read() if the policy has it
+ */
+template<template<typename> typename access>
+std::uint64_t readMostly(std::uint64_t i) {
+	using S = Accessed<access>;
+	if (i % writeEvery == 0) {
+		auto stats = S::get();
+		++stats->hits;
+		return stats->misses;
+	}
+	if constexpr (requires { S::read(); }) {
+		if constexpr (std::is_same_v<decltype(S::read()), Stats>)
+			return S::read().hits;
+		else
+			return S::read()->hits;
+	}
+	else
+		return S::get()->hits;
+}
+
+void compareAccessPolicies() {
+	Accessed<MutexAccess> mutex;
+	Accessed<SharedMutexAccess> shared;
+	Accessed<SeqLockAccess> seqLock;
+	Accessed<SpinLockAccess> spinLock;
+	for (unsigned threads = 1; threads <= 64; threads *= 2) {
+		std::printf("read mostly access, %u threads\n", threads);
+		Bench::report("MutexAccess", contended(threads, &readMostly<MutexAccess>, accessesPerThread));
+		Bench::report("SharedMutexAccess", contended(threads, &readMostly<SharedMutexAccess>, accessesPerThread));
+		Bench::report("SeqLockAccess", contended(threads, &readMostly<SeqLockAccess>, accessesPerThread));
+		Bench::report("SpinLockAccess", contended(threads, &readMostly<SpinLockAccess>, accessesPerThread));
+	}
+}
+
+int main() {
+	scheduleLifetimes();
+	NoLock noLock;
+	Mutex mutex;
+	Futex futex;
+	Once once;
+	Static staticStorage;
+	noLock.get();
+	mutex.get();
+	futex.get();
+	once.get();
+	staticStorage.get();
+	const unsigned maxThreads = std::max(8u, std::thread::hardware_concurrency());
+	for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+		std::printf("%u threads\n", threads);
+		Bench::report("raw pointer", contended(threads, [](std::uint64_t) { return rawPointer->value; }));
+		Bench::report("Singleton (no lock)", contended(threads, [](std::uint64_t) { return NoLock::get().value; }));
+		Bench::report("MTSingleton_t (mutex)", contended(threads, [](std::uint64_t) { return Mutex::get().value; }));
+		Bench::report("SingletonFutexLock", contended(threads, [](std::uint64_t) { return Futex::get().value; }));
+		Bench::report("OnceSingleton_t (call_once)", contended(threads, [](std::uint64_t) { return Once::get().value; }));
+		Bench::report("StaticStorageCreatePolicy", contended(threads, [](std::uint64_t) { return Static::get().value; }));
+		Bench::report("ConstantInitCreatePolicy", contended(threads, [](std::uint64_t) { return Constant::get().value; }));
+	}
+	compareAccessPolicies();
+	return 0;
+}
@@ -0,0 +1,203 @@
+#include "Bench.hpp"
+#include <ClosedVisitable.hpp>
+#include <StaticVisitable.hpp>
+#include <Visitable.hpp>
+#include <Visitor.hpp>
+#include <VisitorAlgorithms.hpp>
+#include <functional>
+#include <memory>
+#include <random>
+#include <variant>
+#include <vector>
+
+using namespace SUtil;
+
+// Compares accept() over a shuffled vector of 4 node types for each dispatch mode
+constexpr std::size_t nodeCount = 1 << 16;
+constexpr std::uint64_t passes = 200;
+
+#define DISPATCH_NODES(prefix, base) \
+	struct prefix##A : public base { int v = 1; MAKE_VISITABLE(int); }; \
+	struct prefix##B : public base { int v = 2; MAKE_VISITABLE(int); }; \
+	struct prefix##C : public base { int v = 3; MAKE_VISITABLE(int); }; \
+	struct prefix##D : public base { int v = 4; MAKE_VISITABLE(int); }; \
+	struct prefix##Visitor : public Visitor<int, prefix##A, prefix##B, prefix##C, prefix##D> { \
+		int visit(prefix##A& n) override { return n.v; } \
+		int visit(prefix##B& n) override { return n.v * 2; } \
+		int visit(prefix##C& n) override { return n.v + 7; } \
+		int visit(prefix##D& n) override { return n.v ^ 5; } \
+	};
+
+using CastBase = BaseVisitable<int>;
+using TableBase = BaseVisitable<int, ExceptionUnknownPolicy, MutableAndConstVisitablePolicy, TableDispatchPolicy>;
+using CachedBase = BaseVisitable<int, ExceptionUnknownPolicy, MutableAndConstVisitablePolicy, CachedDispatchPolicy<>>;
+
+DISPATCH_NODES(Cast, CastBase)
+DISPATCH_NODES(Table, TableBase)
+DISPATCH_NODES(Cached, CachedBase)
+
+struct CompactCastVisitor : public CompactVisitor<int, CastA, CastB, CastC, CastD> {
+	int visit(CastA& n) override { return n.v; }
+	int visit(CastB& n) override { return n.v * 2; }
+	int visit(CastC& n) override { return n.v + 7; }
+	int visit(CastD& n) override { return n.v ^ 5; }
+};
+struct CompactTableVisitor : public CompactVisitor<int, TableA, TableB, TableC, TableD> {
+	int visit(TableA& n) override { return n.v; }
+	int visit(TableB& n) override { return n.v * 2; }
+	int visit(TableC& n) override { return n.v + 7; }
+	int visit(TableD& n) override { return n.v ^ 5; }
+};
+
+struct ClosedA;
+struct ClosedB;
+struct ClosedC;
+struct ClosedD;
+using ClosedNodes = TL::TypeList<ClosedA, ClosedB, ClosedC, ClosedD>;
+struct ClosedA : public ClosedVisitableNode<ClosedA, ClosedNodes, int> { int v = 1; };
+struct ClosedB : public ClosedVisitableNode<ClosedB, ClosedNodes, int> { int v = 2; };
+struct ClosedC : public ClosedVisitableNode<ClosedC, ClosedNodes, int> { int v = 3; };
+struct ClosedD : public ClosedVisitableNode<ClosedD, ClosedNodes, int> { int v = 4; };
+struct ClosedVisitor final : public Visitor<int, ClosedA, ClosedB, ClosedC, ClosedD> {
+	int visit(ClosedA& n) override { return n.v; }
+	int visit(ClosedB& n) override { return n.v * 2; }
+	int visit(ClosedC& n) override { return n.v + 7; }
+	int visit(ClosedD& n) override { return n.v ^ 5; }
+};
+
+struct StaticLeaf final : public TableBase, public StaticVisitable<StaticLeaf> {
+	int v = 1;
+	MAKE_STATIC_VISITABLE(int);
+};
+struct StaticLeafVisitor final : public Visitor<int, StaticLeaf> {
+	int visit(StaticLeaf& n) override { return n.v + 3; }
+};
+
+struct VariantA { int v = 1; };
+struct VariantB { int v = 2; };
+struct VariantC { int v = 3; };
+struct VariantD { int v = 4; };
+using VariantNode = std::variant<VariantA, VariantB, VariantC, VariantD>;
+struct VariantVisitor {
+	int operator()(VariantA& n) const { return n.v; }
+	int operator()(VariantB& n) const { return n.v * 2; }
+	int operator()(VariantC& n) const { return n.v + 7; }
+	int operator()(VariantD& n) const { return n.v ^ 5; }
+};
+
+/**
+ * Makes nodeCount heap allocated nodes with a random type, the same sequence of types for every mode
+ */
+template<typename Base, typename A, typename B, typename C, typename D>
+std::vector<std::unique_ptr<Base>> makeNodes() {
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int> type(0, 3);
+	std::vector<std::unique_ptr<Base>> nodes;
+	nodes.reserve(nodeCount);
+	for (std::size_t i = 0; i < nodeCount; ++i) {
+		switch (type(rng)) {
+		case 0: nodes.emplace_back(std::make_unique<A>()); break;
+		case 1: nodes.emplace_back(std::make_unique<B>()); break;
+		case 2: nodes.emplace_back(std::make_unique<C>()); break;
+		default: nodes.emplace_back(std::make_unique<D>()); break;
+		}
+	}
+	return nodes;
+}
+
+template<typename Base, typename A, typename B, typename C, typename D, typename V>
+void benchOpen(const char* name) {
+	auto nodes = makeNodes<Base, A, B, C, D>();
+	V visitor;
+	const auto ns = Bench::nsPerOp(passes * nodeCount, [&](std::uint64_t i) {
+		Bench::sink = Bench::sink + nodes[i % nodeCount]->accept(visitor);
+	});
+	Bench::report(name, ns);
+}
+
+template<typename Base, typename A, typename B, typename C, typename D, typename V>
+void benchAcceptAll(const char* name, VisitOrder order) {
+	auto nodes = makeNodes<Base, A, B, C, D>();
+	V visitor;
+	const auto ns = Bench::nsPerOp(passes, [&](std::uint64_t) {
+		Bench::sink = Bench::sink + acceptAll(nodes, visitor, 0, std::plus<int>{}, order);
+	});
+	Bench::report(name, ns / nodeCount);
+}
+
+void benchClosed() {
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int> type(0, 3);
+	std::vector<std::unique_ptr<ClosedVisitable<ClosedNodes, int>, void(*)(ClosedVisitable<ClosedNodes, int>*)>> nodes;
+	nodes.reserve(nodeCount);
+	// ClosedVisitable is not polymorphic so the deleter must know the concrete type
+	auto make = [&nodes]<typename T>() {
+		nodes.emplace_back(new T(), [](ClosedVisitable<ClosedNodes, int>* n) { delete static_cast<T*>(n); });
+	};
+	for (std::size_t i = 0; i < nodeCount; ++i) {
+		switch (type(rng)) {
+		case 0: make.operator()<ClosedA>(); break;
+		case 1: make.operator()<ClosedB>(); break;
+		case 2: make.operator()<ClosedC>(); break;
+		default: make.operator()<ClosedD>(); break;
+		}
+	}
+	ClosedVisitor visitor;
+	const auto ns = Bench::nsPerOp(passes * nodeCount, [&](std::uint64_t i) {
+		Bench::sink = Bench::sink + nodes[i % nodeCount]->accept(visitor);
+	});
+	Bench::report("ClosedVisitable", ns);
+}
+
+/**
+ * Same leaves visited through their static type and through the BaseVisitable
+ */
+void benchStatic() {
+	std::vector<StaticLeaf> leaves(nodeCount);
+	StaticLeafVisitor visitor;
+	Bench::report("StaticVisitable (static)", Bench::nsPerOp(passes * nodeCount, [&](std::uint64_t i) {
+		Bench::sink = Bench::sink + leaves[i % nodeCount].accept(visitor);
+	}));
+	std::vector<TableBase*> bases;
+	for (auto& leaf : leaves)
+		bases.push_back(&leaf);
+	Bench::report("StaticVisitable (through TableBase)", Bench::nsPerOp(passes * nodeCount, [&](std::uint64_t i) {
+		Bench::sink = Bench::sink + bases[i % nodeCount]->accept(visitor);
+	}));
+}
+
+void benchVariant() {
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int> type(0, 3);
+	std::vector<std::unique_ptr<VariantNode>> nodes;
+	nodes.reserve(nodeCount);
+	for (std::size_t i = 0; i < nodeCount; ++i) {
+		switch (type(rng)) {
+		case 0: nodes.emplace_back(std::make_unique<VariantNode>(VariantA{})); break;
+		case 1: nodes.emplace_back(std::make_unique<VariantNode>(VariantB{})); break;
+		case 2: nodes.emplace_back(std::make_unique<VariantNode>(VariantC{})); break;
+		default: nodes.emplace_back(std::make_unique<VariantNode>(VariantD{})); break;
+		}
+	}
+	const auto ns = Bench::nsPerOp(passes * nodeCount, [&](std::uint64_t i) {
+		Bench::sink = Bench::sink + std::visit(VariantVisitor{}, *nodes[i % nodeCount]);
+	});
+	Bench::report("std::visit", ns);
+}
+
+int main() {
+	benchOpen<CastBase, CastA, CastB, CastC, CastD, CastVisitor>("DynamicCastDispatchPolicy");
+	benchOpen<CastBase, CastA, CastB, CastC, CastD, CompactCastVisitor>("DynamicCastDispatch (CompactVisitor)");
+	benchOpen<TableBase, TableA, TableB, TableC, TableD, TableVisitor>("TableDispatchPolicy");
+	benchOpen<CachedBase, CachedA, CachedB, CachedC, CachedD, CachedVisitor>("CachedDispatchPolicy");
+	benchOpen<TableBase, TableA, TableB, TableC, TableD, CompactTableVisitor>("TableDispatchPolicy (CompactVisitor)");
+	benchAcceptAll<CastBase, CastA, CastB, CastC, CastD, CastVisitor>("acceptAll (grouped)", VisitOrder::grouped);
+	benchAcceptAll<CastBase, CastA, CastB, CastC, CastD, CastVisitor>("acceptAll (preserved)", VisitOrder::preserved);
+	benchAcceptAll<TableBase, TableA, TableB, TableC, TableD, TableVisitor>("acceptAll (grouped, table)", VisitOrder::grouped);
+	benchAcceptAll<TableBase, TableA, TableB, TableC, TableD, TableVisitor>("acceptAll (preserved, table)",
+		VisitOrder::preserved);
+	benchClosed();
+	benchStatic();
+	benchVariant();
+	return 0;
+}
@@ -0,0 +1,138 @@
+#pragma once
+#ifndef _ARENA_H
+#define _ARENA_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+/**
+ * Monotonic arena allocator
+ * Usage:
+ *	- T* obj = arena.create<T>(args...) constructs a T in the arena
+ *	- objects are never freed one by one, they are all destroyed (in reverse order of creation) when the arena
+ *		is reset or destroyed
+ *	- memory is taken from the system in blocks of at least blockSize bytes
+ * An arena is not thread safe
+ */
+namespace SUtil {
+	class Arena {
+	private:
+		struct Block {
+			Block* next;
+			std::size_t size;
+		};
+
+		/// destroys an object that is not trivially destructible, allocated in the arena itself
+		struct Finalizer {
+			void (*destroy)(void*);
+			void* object;
+			Finalizer* next;
+		};
+
+		static constexpr std::size_t blockAlignment = alignof(std::max_align_t);
+		static constexpr std::size_t headerSize = (sizeof(Block) + blockAlignment - 1) / blockAlignment * blockAlignment;
+
+		Block* blocks = nullptr;
+		std::byte* cursor = nullptr;
+		std::byte* end = nullptr;
+		Finalizer* finalizers = nullptr;
+		std::size_t blockSize;
+		std::size_t used = 0;
+
+		void grow(std::size_t size, std::size_t alignment) {
+			const auto bytes = std::max(blockSize, headerSize + size + alignment);
+			auto* block = ::new (::operator new(bytes, std::align_val_t(blockAlignment))) Block{ blocks, bytes };
+			blocks = block;
+			cursor = reinterpret_cast<std::byte*>(block) + headerSize;
+			end = reinterpret_cast<std::byte*>(block) + bytes;
+		}
+
+		void destroyObjects() noexcept {
+			while (finalizers) {
+				auto* next = finalizers->next;
+				finalizers->destroy(finalizers->object);
+				finalizers = next;
+			}
+		}
+	public:
+		/**
+		 * @param blockSize the minimum size of the blocks taken from the system
+		 */
+		explicit Arena(std::size_t blockSize = 64 * 1024) noexcept : blockSize(blockSize) {}
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		~Arena() {
+			reset();
+		}
+
+		/**
+		 * @param alignment a power of 2
+		 * @return uninitialized memory that lives until the arena is reset
+		 */
+		void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) {
+			auto space = static_cast<std::size_t>(end - cursor);
+			void* ptr = cursor;
+			if (!cursor || !std::align(alignment, size, ptr, space)) {
+				grow(size, alignment);
+				space = static_cast<std::size_t>(end - cursor);
+				ptr = cursor;
+				std::align(alignment, size, ptr, space);
+			}
+			cursor = static_cast<std::byte*>(ptr) + size;
+			used += size;
+			return ptr;
+		}
+
+		/**
+		 * Constructs a T in the arena, it is destroyed when the arena is reset
+		 */
+		template<typename T, typename ... Args>
+		T* create(Args&& ... args) {
+			if constexpr (std::is_trivially_destructible_v<T>)
+				return ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			else {
+				auto* finalizer = static_cast<Finalizer*>(allocate(sizeof(Finalizer), alignof(Finalizer)));
+				auto* obj = ::new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+				finalizers = ::new (finalizer) Finalizer{ [](void* p) { static_cast<T*>(p)->~T(); }, obj, finalizers };
+				return obj;
+			}
+		}
+
+		/**
+		 * @return uninitialized storage for count trivial objects
+		 */
+		template<typename T>
+			requires std::is_trivial_v<T>
+		std::span<T> allocateArray(std::size_t count) {
+			return { static_cast<T*>(allocate(sizeof(T) * count, alignof(T))), count };
+		}
+
+		/**
+		 * Destroys every object and releases all memory
+		 */
+		void reset() noexcept {
+			destroyObjects();
+			while (blocks) {
+				auto* next = blocks->next;
+				::operator delete(blocks, std::align_val_t(blockAlignment));
+				blocks = next;
+			}
+			cursor = end = nullptr;
+			used = 0;
+		}
+
+		/**
+		 * @return bytes handed out since the last reset, not counting padding
+		 */
+		std::size_t bytesUsed() const noexcept {
+			return used;
+		}
+	};
+}
+#endif
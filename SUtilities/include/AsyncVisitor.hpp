@@ -0,0 +1,174 @@
+#pragma once
+#ifndef _ASYNC_VISITOR_H
+#define _ASYNC_VISITOR_H
+#include "Task.hpp"
+#include "Visitable.hpp"
+#include "Visitor.hpp"
+#include "VisitorAlgorithms.hpp"
+#include <algorithm>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+/**
+ * Visitors whose visits are coroutines, so that many visits can wait on I/O at the same time
+ * Usage:
+ *	- subtype AsyncVisitor<ReturnType, Ts...> and implement Task<ReturnType> visit(T&) as coroutines
+ *	- make the visitables inherit from AsyncVisitable<ReturnType> and use MAKE_VISITABLE(Task<ReturnType>)
+ *	- co_await visitable.acceptAsync(visitor) inside a task, or run it with EventLoop::run (see Task.hpp)
+ *	- acceptAllAsync(loop, range, visitor, maxInFlight) visits a range with at most maxInFlight visits
+ *		suspended at a time
+ * AsyncVisitor is a Visitor<Task<ReturnType>, Ts...>, so it is dispatched like any other visitor. The visitor and
+ * the visited objects must outlive the tasks visiting them
+ */
+namespace SUtil {
+	/**
+	 * @param <ReturnType> the result of the tasks returned by the visit functions
+	 * @param <Ts> the types that you would like to be able to visit
+	 */
+	template<typename ReturnType, typename ... Ts>
+	using AsyncVisitor = Visitor<Task<ReturnType>, Ts...>;
+
+	/**
+	 * Not for external use
+	 */
+	namespace AsyncVisitorTracker {
+		/**
+		 * Visits inside the task, so that errors of the dispatch are thrown when the task is awaited
+		 */
+		template<typename ReturnType, typename Visitable>
+		Task<ReturnType> acceptAsync(Visitable& visitable, BaseVisitor& visitor) {
+			co_return co_await visitable.accept(visitor);
+		}
+
+		/**
+		 * The visits of an acceptAllAsync that are in flight
+		 */
+		struct Batch {
+			EventLoop& loop;
+			AsyncSemaphore permits;
+			std::size_t running = 0;
+			std::coroutine_handle<> joiner = nullptr;
+			std::exception_ptr error = nullptr;
+
+			void finish() {
+				permits.release();
+				if (--running == 0 && joiner)
+					loop.post(std::exchange(joiner, nullptr));
+			}
+
+			/**
+			 * @return an awaitable that resumes the awaiter once every visit is done
+			 */
+			auto join() noexcept {
+				struct Awaiter {
+					Batch& batch;
+
+					bool await_ready() const noexcept {
+						return batch.running == 0;
+					}
+
+					void await_suspend(std::coroutine_handle<> coroutine) noexcept {
+						batch.joiner = coroutine;
+					}
+
+					void await_resume() const noexcept {}
+				};
+				return Awaiter{ *this };
+			}
+		};
+
+		template<typename ReturnType, typename Element>
+		Task<void> visitOne(Batch& batch, Element* element, BaseVisitor& visitor,
+			std::optional<TaskTracker::result_t<ReturnType>>* result) {
+			try {
+				if constexpr (std::is_void_v<ReturnType>)
+					co_await element->accept(visitor);
+				else
+					result->emplace(co_await element->accept(visitor));
+			}
+			catch (...) {
+				if (!batch.error)
+					batch.error = std::current_exception();
+			}
+			batch.finish();
+		}
+
+		template<typename ReturnType>
+		using batch_result_t = std::conditional_t<std::is_void_v<ReturnType>, void, std::vector<ReturnType>>;
+
+		template<typename ReturnType, typename Element>
+		Task<batch_result_t<ReturnType>> acceptAll(EventLoop& loop, std::vector<Element*> elements,
+			BaseVisitor& visitor, std::size_t maxInFlight) {
+			Batch batch{ loop, AsyncSemaphore(loop, std::max<std::size_t>(maxInFlight, 1)) };
+			std::vector<std::optional<TaskTracker::result_t<ReturnType>>> results;
+			if constexpr (!std::is_void_v<ReturnType>)
+				results.resize(elements.size());
+			for (std::size_t i = 0; i < elements.size(); ++i) {
+				co_await batch.permits.acquire();
+				if (batch.error) {
+					batch.permits.release();
+					break;
+				}
+				++batch.running;
+				loop.spawn(visitOne<ReturnType>(batch, elements[i], visitor,
+					std::is_void_v<ReturnType> ? nullptr : &results[i]));
+			}
+			co_await batch.join();
+			if (batch.error)
+				std::rethrow_exception(batch.error);
+			if constexpr (!std::is_void_v<ReturnType>) {
+				std::vector<ReturnType> values;
+				values.reserve(results.size());
+				for (auto& result : results)
+					values.push_back(std::move(*result));
+				co_return values;
+			}
+		}
+	}
+
+	/**
+	 * The parent class of types visited by AsyncVisitors
+	 * @param <ReturnType> the result of the tasks returned by accept
+	 */
+	template<typename ReturnType = void,
+		template<typename> typename up = ExceptionUnknownPolicy,
+		template<typename> typename accessPolicy = MutableAndConstVisitablePolicy,
+		typename dispatchPolicy = DefaultDispatchPolicy
+	>
+	class AsyncVisitable : public BaseVisitable<Task<ReturnType>, up, accessPolicy, dispatchPolicy> {
+	public:
+		/**
+		 * Like accept(), but an unknown visitor is reported when the task is awaited rather than when it is created
+		 */
+		Task<ReturnType> acceptAsync(BaseVisitor& visitor) {
+			return AsyncVisitorTracker::acceptAsync<ReturnType>(*this, visitor);
+		}
+
+		Task<ReturnType> acceptAsync(BaseVisitor& visitor) const {
+			return AsyncVisitorTracker::acceptAsync<ReturnType>(*this, visitor);
+		}
+	};
+
+	/**
+	 * Visits every element of a range of pointers to visitables on the event loop
+	 * Up to maxInFlight visits are started before waiting for one of them to finish. If a visit throws,
+	 * no more visits are started and the first exception is rethrown once the started ones are done
+	 * @param visitor a subtype of AsyncVisitor<ReturnType, Ts...>
+	 * @return a task producing the results in the order of the range, or nothing if ReturnType is void
+	 */
+	template<std::ranges::input_range Range, TypedVisitor V>
+		requires is_task_v<visitor_return_t<V>>
+	auto acceptAllAsync(EventLoop& loop, Range&& range, V& visitor, std::size_t maxInFlight = 64) {
+		using ReturnType = typename visitor_return_t<V>::value_type;
+		return AsyncVisitorTracker::acceptAll<ReturnType>(loop,
+			VisitorAlgorithmsTracker::gatherElements(std::forward<Range>(range)),
+			static_cast<BaseVisitor&>(visitor), maxInFlight);
+	}
+}
+#endif
@@ -0,0 +1,362 @@
+#pragma once
+#ifndef _CACHING_VISITOR_H
+#define _CACHING_VISITOR_H
+#include "Visitor.hpp"
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+/**
+ * Incremental visitation
+ * A CachingVisitor remembers the result of visiting each node and reuses it until the node, or a node
+ * whose result it used, changes
+ * Usage:
+ *	- make each node you wish to cache results for inherit from Versioned and call markDirty() after every change
+ *	- subtype CachingVisitor<ReturnType, Ts...> and implement visit(T&) as for a Visitor
+ *		or BasicCachingVisitor<ReturnType, EvictionPolicy, Ts...> to choose which results are evicted
+ *	- get results with evaluate(node) instead of node.accept(visitor), including for the children of a node
+ *		inside visit(). Nodes evaluated while visiting a node become its dependencies
+ *	- visit functions must be pure: their result may only depend on the node and the results of its dependencies
+ *	- call invalidate(node) or clear() before destroying a node that has a cached result
+ * Validation:
+ *	- every change increments a global revision. A result is valid if its node and all its dependencies have
+ *		not changed and the dependencies have not been recomputed since it was computed
+ *	- a result whose dependency was evicted is recomputed
+ *	- once validated, a result is not checked again until the next change anywhere
+ * A CachingVisitor is not thread safe, nodes must not change while they are being evaluated
+ */
+namespace SUtil {
+	/**
+	 * Not for external use
+	 */
+	namespace CachingVisitorTracker {
+		/// revision 0 is never the revision of a change
+		inline std::atomic<std::uint64_t> revision{ 0 };
+
+		inline std::uint64_t nextRevision() noexcept {
+			return revision.fetch_add(1, std::memory_order_relaxed) + 1;
+		}
+
+		inline std::uint64_t currentRevision() noexcept {
+			return revision.load(std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * The parent class of nodes whose visit results can be cached
+	 * A copy is a new node, so it gets a new version
+	 */
+	class Versioned {
+	private:
+		std::uint64_t stamp = CachingVisitorTracker::nextRevision();
+	public:
+		Versioned() = default;
+		Versioned(const Versioned&) noexcept {}
+
+		Versioned& operator=(const Versioned&) noexcept {
+			markDirty();
+			return *this;
+		}
+
+		/**
+		 * @return the revision of the last change to this node
+		 */
+		std::uint64_t version() const noexcept {
+			return stamp;
+		}
+
+		/**
+		 * Invalidates the cached results of this node and of every node that depends on it
+		 */
+		void markDirty() noexcept {
+			stamp = CachingVisitorTracker::nextRevision();
+		}
+	protected:
+		~Versioned() = default;
+	};
+
+	/**
+	 * Requires a Position type and the functions
+	 *	- Position inserted(const Versioned*): called when a node is cached
+	 *	- void used(Position): called on each cache hit
+	 *	- void erased(Position): called when a node is removed from the cache
+	 *	- const Versioned* victim(): the node to evict when the cache is full
+	 */
+	template<typename T>
+	concept EvictionPolicy = std::default_initializable<T> &&
+		requires(T policy, const Versioned* node, typename T::Position position) {
+		{policy.inserted(node)} -> std::same_as<typename T::Position>;
+		policy.used(position);
+		policy.erased(position);
+		{policy.victim()} -> std::same_as<const Versioned*>;
+	};
+
+	/**
+	 * Evicts the least recently used result
+	 */
+	class LruEvictionPolicy {
+	private:
+		std::list<const Versioned*> order;
+	public:
+		using Position = std::list<const Versioned*>::iterator;
+
+		Position inserted(const Versioned* node) {
+			order.push_front(node);
+			return order.begin();
+		}
+
+		void used(Position position) noexcept {
+			order.splice(order.begin(), order, position);
+		}
+
+		void erased(Position position) noexcept {
+			order.erase(position);
+		}
+
+		const Versioned* victim() const noexcept {
+			return order.back();
+		}
+	};
+
+	/**
+	 * Evicts the oldest result
+	 */
+	class FifoEvictionPolicy {
+	private:
+		std::list<const Versioned*> order;
+	public:
+		using Position = std::list<const Versioned*>::iterator;
+
+		Position inserted(const Versioned* node) {
+			order.push_front(node);
+			return order.begin();
+		}
+
+		void used(Position) noexcept {}
+
+		void erased(Position position) noexcept {
+			order.erase(position);
+		}
+
+		const Versioned* victim() const noexcept {
+			return order.back();
+		}
+	};
+
+	struct CachingVisitorStats {
+		std::uint64_t hits;
+		std::uint64_t misses;
+		std::uint64_t evictions;
+	};
+
+	/**
+	 * Base class for visitors that cache their results
+	 * @param <ReturnType> the return type of the visit() function, must be copy constructible
+	 * @param <evictionPolicy> which result is evicted when the cache is full
+	 * @param <Ts> the types that you would like to be able to visit
+	 */
+	template<typename ReturnType, EvictionPolicy evictionPolicy, typename ... Ts>
+		requires (!std::is_void_v<ReturnType> && std::copy_constructible<ReturnType>)
+	class BasicCachingVisitor : public Visitor<ReturnType, Ts...> {
+	public:
+		/**
+		 * @param capacity max amount of cached results
+		 */
+		explicit BasicCachingVisitor(std::size_t capacity = 1024) : maxSize(capacity) {}
+
+		/**
+		 * Gets the result of visiting the node, from the cache if it is still valid
+		 * When called from a visit function, the node becomes a dependency of the node being visited
+		 * @param node a visitable that inherits from Versioned
+		 */
+		template<typename Node>
+			requires std::derived_from<std::remove_const_t<Node>, Versioned>
+		ReturnType evaluate(Node& node) {
+			const Versioned* key = &node;
+			auto it = cache.find(key);
+			if (it != cache.end() && valid(key, it->second)) {
+				++counters.hits;
+				eviction.used(it->second.position);
+				recordDependency(key, it->second.computedAt);
+				return *it->second.result;
+			}
+			++counters.misses;
+			const auto start = CachingVisitorTracker::currentRevision();
+			frames.emplace_back();
+			std::optional<ReturnType> result;
+			try {
+				result.emplace(node.accept(*this));
+			}
+			catch (...) {
+				frames.pop_back();
+				throw;
+			}
+			auto dependencies = std::move(frames.back());
+			frames.pop_back();
+			// visiting the dependencies may have evicted the result
+			it = cache.find(key);
+			if (node.version() > start) {
+				// the node changed while it was visited, don't cache the result
+				if (it != cache.end())
+					erase(it);
+				recordDependency(key, 0);
+				return std::move(*result);
+			}
+			if (it == cache.end())
+				it = insert(key);
+			if (it == cache.end()) {
+				recordDependency(key, 0);
+				return std::move(*result);
+			}
+			auto& entry = it->second;
+			entry.result = result;
+			entry.version = node.version();
+			entry.computedAt = ++computations;
+			entry.verifiedAt = CachingVisitorTracker::currentRevision();
+			entry.dependencies = std::move(dependencies);
+			recordDependency(key, entry.computedAt);
+			return std::move(*result);
+		}
+
+		/**
+		 * Removes the cached result of the node, results that depend on it are recomputed as well
+		 */
+		void invalidate(const Versioned& node) {
+			if (auto it = cache.find(&node); it != cache.end()) {
+				erase(it);
+				// results validated at the current revision must be validated again
+				CachingVisitorTracker::nextRevision();
+			}
+		}
+
+		/**
+		 * Removes all cached results
+		 */
+		void clear() {
+			while (!cache.empty())
+				erase(cache.begin());
+		}
+
+		/**
+		 * Changes the max amount of cached results, evicting results if there are more than capacity
+		 */
+		void reserve(std::size_t capacity) {
+			maxSize = capacity;
+			while (cache.size() > maxSize)
+				evict();
+		}
+
+		std::size_t size() const noexcept {
+			return cache.size();
+		}
+
+		std::size_t capacity() const noexcept {
+			return maxSize;
+		}
+
+		CachingVisitorStats stats() const noexcept {
+			return counters;
+		}
+	private:
+		struct Dependency {
+			const Versioned* node;
+			/// computedAt of the dependency's result when it was used, 0 if it wasn't cached
+			std::uint64_t computedAt;
+		};
+
+		struct Entry {
+			std::optional<ReturnType> result;
+			std::uint64_t version = 0;
+			/// unique among all results of this visitor
+			std::uint64_t computedAt = 0;
+			/// the last revision this result was known to be valid at
+			std::uint64_t verifiedAt = 0;
+			std::vector<Dependency> dependencies;
+			typename evictionPolicy::Position position;
+		};
+
+		std::unordered_map<const Versioned*, Entry> cache;
+		evictionPolicy eviction;
+		std::uint64_t computations = 0;
+		/// dependencies of the nodes being visited, innermost last
+		std::vector<std::vector<Dependency>> frames;
+		/// results whose dependencies are being validated, innermost last
+		struct Check {
+			Entry* entry;
+			std::size_t next;
+		};
+		std::vector<Check> checks;
+		std::size_t maxSize;
+		CachingVisitorStats counters{ 0, 0, 0 };
+
+		void recordDependency(const Versioned* node, std::uint64_t computedAt) {
+			if (!frames.empty())
+				frames.back().push_back({ node, computedAt });
+		}
+
+		bool valid(const Versioned* node, Entry& entry) {
+			if (!entry.result || node->version() != entry.version)
+				return false;
+			const auto now = CachingVisitorTracker::currentRevision();
+			if (entry.verifiedAt == now)
+				return true;
+			// depth first with an explicit stack, dependency chains can be deeper than the call stack
+			checks.clear();
+			checks.push_back({ &entry, 0 });
+			while (!checks.empty()) {
+				auto& check = checks.back();
+				if (check.next == check.entry->dependencies.size()) {
+					check.entry->verifiedAt = now;
+					checks.pop_back();
+					continue;
+				}
+				const auto& dependency = check.entry->dependencies[check.next++];
+				if (dependency.computedAt == 0)
+					return false;
+				auto it = cache.find(dependency.node);
+				// a recomputed dependency may have a different result
+				if (it == cache.end() || it->second.computedAt != dependency.computedAt)
+					return false;
+				auto& result = it->second;
+				if (!result.result || dependency.node->version() != result.version)
+					return false;
+				if (result.verifiedAt != now)
+					checks.push_back({ &result, 0 });
+			}
+			return true;
+		}
+
+		auto insert(const Versioned* node) {
+			if (maxSize == 0)
+				return cache.end();
+			if (cache.size() >= maxSize)
+				evict();
+			auto it = cache.try_emplace(node).first;
+			it->second.position = eviction.inserted(node);
+			return it;
+		}
+
+		void erase(typename std::unordered_map<const Versioned*, Entry>::iterator it) {
+			eviction.erased(it->second.position);
+			cache.erase(it);
+		}
+
+		void evict() {
+			erase(cache.find(eviction.victim()));
+			++counters.evictions;
+		}
+	};
+
+	/**
+	 * Caching visitor that evicts the least recently used result
+	 */
+	template<typename ReturnType, typename ... Ts>
+	using CachingVisitor = BasicCachingVisitor<ReturnType, LruEvictionPolicy, Ts...>;
+}
+#endif
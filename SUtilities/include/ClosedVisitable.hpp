@@ -0,0 +1,147 @@
+#pragma once
+#ifndef _CLOSED_VISITABLE_H
+#define _CLOSED_VISITABLE_H
+#include "TypeList.hpp"
+#include "Visitor.hpp"
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+/**
+ * Closed visitable hierarchies
+ * For hierarchies where every concrete type is known up front. The visitable stores a
+ * discriminant (the index of its type in the type list) instead of a vtable and accept()
+ * indexes a jump table generated at compile time. Does not use RTTI
+ * Usage:
+ *	- declare the concrete types and the type list of them: using Shapes = TL::TypeList<Circle, Square>;
+ *	- make each concrete type inherit from ClosedVisitableNode<Self, Shapes, ReturnType>
+ *	- visitors subtype the regular Visitor<ReturnType, Ts...>
+ *	- a visitor that cannot visit every type in the list is a compile error
+ */
+namespace SUtil {
+	/**
+	 * Smallest unsigned type that can hold an index into a type list with the specified size
+	 */
+	template<unsigned size>
+	using discriminant_t = std::conditional_t<size <= 0xFF, std::uint8_t,
+		std::conditional_t<size <= 0xFFFF, std::uint16_t, std::uint32_t>>;
+
+	/**
+	 * A visitor that can visit T, either with visit(T&) or visit(const T&)
+	 */
+	template<typename V, typename T, typename ReturnType>
+	concept ClosedVisitorFor = std::is_base_of_v<VisitorSingle<T, ReturnType>, V> ||
+		std::is_base_of_v<VisitorSingle<std::add_const_t<T>, ReturnType>, V>;
+
+	/**
+	 * Not for external use
+	 */
+	namespace ClosedVisitorTracker {
+		template<typename V, typename list, typename ReturnType, bool isConst, std::size_t ... Is>
+		constexpr bool visitsAll(std::index_sequence<Is...>) {
+			return (ClosedVisitorFor<V, std::conditional_t<isConst, const TL::get_t<list, Is>, TL::get_t<list, Is>>,
+				ReturnType> && ...);
+		}
+	}
+
+	/**
+	 * A visitor that can visit every type in list
+	 */
+	template<typename V, typename list, typename ReturnType>
+	concept ClosedVisitorOf = TL::TList<list> &&
+		ClosedVisitorTracker::visitsAll<V, list, ReturnType, false>(std::make_index_sequence<TL::size<list>()>{});
+
+	/**
+	 * A visitor that can visit every type in list when the visited objects are const
+	 */
+	template<typename V, typename list, typename ReturnType>
+	concept ConstClosedVisitorOf = TL::TList<list> &&
+		ClosedVisitorTracker::visitsAll<V, list, ReturnType, true>(std::make_index_sequence<TL::size<list>()>{});
+
+	/**
+	 * The parent class of all types in a closed hierarchy
+	 * Not polymorphic, cannot be deleted through a pointer to this class
+	 * @param <list> all concrete types of the hierarchy
+	 * @param <ReturnType> the return type of the accept function
+	 */
+	template<TL::TList list, typename ReturnType = void>
+	class ClosedVisitable {
+	public:
+		using Types = list;
+		using Discriminant = discriminant_t<TL::size<list>()>;
+
+		/**
+		 * @return the index of the dynamic type of this object in the type list
+		 */
+		Discriminant discriminant() const noexcept {
+			return tag;
+		}
+
+		/**
+		 * @return true if the dynamic type of this object is T
+		 */
+		template<typename T>
+		bool holds() const noexcept {
+			static_assert(TL::has<list, T>(), "T is not part of the closed hierarchy");
+			return tag == TL::find<list, T>();
+		}
+
+		template<ClosedVisitorOf<list, ReturnType> V>
+		ReturnType accept(V& visitor) {
+			return jumpTable<V, ClosedVisitable>[tag](*this, visitor);
+		}
+
+		template<ConstClosedVisitorOf<list, ReturnType> V>
+		ReturnType accept(V& visitor) const {
+			return jumpTable<V, const ClosedVisitable>[tag](*this, visitor);
+		}
+	protected:
+		explicit ClosedVisitable(Discriminant tag) noexcept : tag(tag) {}
+		~ClosedVisitable() = default;
+		/// protected so that only objects of the same concrete type are copied, which keeps the discriminant correct
+		ClosedVisitable(const ClosedVisitable&) = default;
+		ClosedVisitable& operator=(const ClosedVisitable&) = default;
+	private:
+		Discriminant tag;
+
+		/**
+		 * Calls the visit function for T, prefering visit(T&) over visit(const T&)
+		 * The function is called through V when V declares it, so that it can be devirtualized and inlined
+		 * if V is final. Otherwise it is called through the VisitorSingle that declares it
+		 * @param <Self> ClosedVisitable, possibly const
+		 */
+		template<typename T, typename V, typename Self>
+		static ReturnType visitAs(Self& visited, V& visitor) {
+			using Visited = std::conditional_t<std::is_const_v<Self>, const T, T>;
+			using Param = std::conditional_t<std::is_base_of_v<VisitorSingle<Visited, ReturnType>, V>, Visited, const T>;
+			if constexpr (requires { static_cast<ReturnType(V::*)(Param&)>(&V::visit); })
+				return visitor.visit(static_cast<Param&>(static_cast<Visited&>(visited)));
+			else
+				return static_cast<VisitorSingle<Param, ReturnType>&>(visitor).visit(static_cast<Visited&>(visited));
+		}
+
+		template<typename V, typename Self, std::size_t ... Is>
+		static constexpr auto makeJumpTable(std::index_sequence<Is...>) {
+			return std::array<ReturnType(*)(Self&, V&), sizeof...(Is)>{
+				&visitAs<TL::get_t<list, Is>, V, Self>...
+			};
+		}
+
+		template<typename V, typename Self>
+		static constexpr auto jumpTable = makeJumpTable<V, Self>(std::make_index_sequence<TL::size<list>()>{});
+	};
+
+	/**
+	 * Sets the discriminant of a concrete type in a closed hierarchy
+	 * @param <Derived> the concrete type inheriting from this class
+	 */
+	template<typename Derived, TL::TList list, typename ReturnType = void>
+	class ClosedVisitableNode : public ClosedVisitable<list, ReturnType> {
+	protected:
+		ClosedVisitableNode() noexcept : ClosedVisitable<list, ReturnType>(
+			static_cast<typename ClosedVisitable<list, ReturnType>::Discriminant>(TL::find<list, Derived>())) {
+			static_assert(TL::has<list, Derived>(), "Derived is not part of the closed hierarchy");
+		}
+	};
+}
+#endif
@@ -0,0 +1,221 @@
+#pragma once
+#ifndef _GENERATOR_H
+#define _GENERATOR_H
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+/**
+ * Lazy generator coroutines
+ * Usage:
+ *	- write a coroutine returning Generator<T> that co_yields lvalues of type T (or subtypes of T)
+ *	- iterate over it with a range for loop, each element is a reference to the yielded object
+ *	- yielded objects must outlive the suspension of the coroutine
+ *	- destroying the generator before the end stops the coroutine
+ * Coroutine frames are allocated with the FrameAllocator, which recycles the frames of finished coroutines
+ */
+namespace SUtil {
+	/**
+	 * Thread local free lists of coroutine frames, one per size class
+	 * A frame freed on a different thread than it was allocated on is cached by the thread that freed it
+	 */
+	class FrameAllocator {
+	private:
+		static constexpr std::size_t granularity = 64;
+		/// frames larger than (sizeClasses - 1) * granularity are not recycled
+		static constexpr std::size_t sizeClasses = 64;
+		static constexpr std::size_t maxCachedPerClass = 16;
+
+		struct FreeFrame {
+			FreeFrame* next;
+		};
+
+		struct Cache {
+			std::array<FreeFrame*, sizeClasses> heads{};
+			std::array<std::size_t, sizeClasses> counts{};
+
+			~Cache() {
+				for (auto* head : heads) {
+					while (head) {
+						auto* next = head->next;
+						::operator delete(head);
+						head = next;
+					}
+				}
+			}
+		};
+
+		static Cache& cache() noexcept {
+			thread_local Cache frames;
+			return frames;
+		}
+
+		static constexpr std::size_t sizeClass(std::size_t size) noexcept {
+			return (size + granularity - 1) / granularity;
+		}
+	public:
+		static void* allocate(std::size_t size) {
+			const auto index = sizeClass(size);
+			if (index >= sizeClasses)
+				return ::operator new(size);
+			auto& frames = cache();
+			if (auto* frame = frames.heads[index]) {
+				frames.heads[index] = frame->next;
+				--frames.counts[index];
+				return frame;
+			}
+			return ::operator new(index * granularity);
+		}
+
+		/**
+		 * @param size the size passed to allocate
+		 */
+		static void deallocate(void* ptr, std::size_t size) noexcept {
+			const auto index = sizeClass(size);
+			auto& frames = cache();
+			if (index >= sizeClasses || frames.counts[index] == maxCachedPerClass) {
+				::operator delete(ptr);
+				return;
+			}
+			frames.heads[index] = ::new (ptr) FreeFrame{ frames.heads[index] };
+			++frames.counts[index];
+		}
+
+		/**
+		 * @return the amount of frames cached by the calling thread
+		 */
+		static std::size_t cached() noexcept {
+			std::size_t total = 0;
+			for (auto count : cache().counts)
+				total += count;
+			return total;
+		}
+	};
+
+	/**
+	 * @param <T> the type of the yielded objects, possibly const
+	 */
+	template<typename T>
+	class Generator {
+	public:
+		class promise_type {
+		private:
+			T* current = nullptr;
+			std::exception_ptr error;
+			friend class Generator;
+		public:
+			Generator get_return_object() noexcept {
+				return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+
+			std::suspend_always initial_suspend() const noexcept {
+				return {};
+			}
+
+			std::suspend_always final_suspend() const noexcept {
+				return {};
+			}
+
+			std::suspend_always yield_value(T& value) noexcept {
+				current = std::addressof(value);
+				return {};
+			}
+
+			void return_void() const noexcept {}
+
+			void unhandled_exception() noexcept {
+				error = std::current_exception();
+			}
+
+			/// generators cannot co_await
+			template<typename U>
+			std::suspend_never await_transform(U&&) = delete;
+
+			static void* operator new(std::size_t size) {
+				return FrameAllocator::allocate(size);
+			}
+
+			static void operator delete(void* ptr, std::size_t size) noexcept {
+				FrameAllocator::deallocate(ptr, size);
+			}
+		};
+
+		class iterator {
+		private:
+			std::coroutine_handle<promise_type> coroutine;
+		public:
+			using value_type = std::remove_cv_t<T>;
+			using difference_type = std::ptrdiff_t;
+
+			iterator() noexcept = default;
+			explicit iterator(std::coroutine_handle<promise_type> coroutine) noexcept : coroutine(coroutine) {}
+
+			T& operator*() const noexcept {
+				return *coroutine.promise().current;
+			}
+
+			T* operator->() const noexcept {
+				return coroutine.promise().current;
+			}
+
+			iterator& operator++() {
+				Generator::resume(coroutine);
+				return *this;
+			}
+
+			void operator++(int) {
+				++*this;
+			}
+
+			friend bool operator==(const iterator& it, std::default_sentinel_t) noexcept {
+				return !it.coroutine || it.coroutine.done();
+			}
+		};
+
+		Generator(Generator&& other) noexcept : coroutine(std::exchange(other.coroutine, nullptr)) {}
+
+		Generator& operator=(Generator&& other) noexcept {
+			std::swap(coroutine, other.coroutine);
+			return *this;
+		}
+
+		Generator(const Generator&) = delete;
+		Generator& operator=(const Generator&) = delete;
+
+		~Generator() {
+			if (coroutine)
+				coroutine.destroy();
+		}
+
+		/**
+		 * Runs the coroutine until the first yield, can only be called once
+		 */
+		iterator begin() {
+			resume(coroutine);
+			return iterator(coroutine);
+		}
+
+		std::default_sentinel_t end() const noexcept {
+			return {};
+		}
+	private:
+		std::coroutine_handle<promise_type> coroutine;
+
+		explicit Generator(std::coroutine_handle<promise_type> coroutine) noexcept : coroutine(coroutine) {}
+
+		/**
+		 * Resumes the coroutine, rethrowing the exception that ended it if there was one
+		 */
+		static void resume(std::coroutine_handle<promise_type> coroutine) {
+			coroutine.resume();
+			if (coroutine.done() && coroutine.promise().error)
+				std::rethrow_exception(std::exchange(coroutine.promise().error, nullptr));
+		}
+	};
+}
+#endif
@@ -0,0 +1,129 @@
+#pragma once
+#ifndef _MULTI_VISITOR_H
+#define _MULTI_VISITOR_H
+#include "TypeId.hpp"
+#include "TypeList.hpp"
+#include "Visitable.hpp"
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+/**
+ * Double dispatch on two polymorphic objects
+ * The handler for every (lhs type, rhs type) pair is found at compile time and stored in an
+ * N x M function table. At runtime both dynamic types are mapped to their index in the type lists
+ * and the pair is resolved with one table lookup. Nothing is allocated
+ * Usage:
+ *	- write a handler with a visit(L&, R&) overload for every pair you wish to handle
+ *	- using Collide = MultiVisitor<void, TL::TypeList<Ship, Rock>, TL::TypeList<Ship, Rock>, MultiDispatch::symmetric>;
+ *	- Collide::dispatch(handler, a, b);
+ * MultiDispatch:
+ *	- asymmetric: only visit(L&, R&) handles (L, R)
+ *	- symmetric: (L, R) falls back to visit(R&, L&) if there is no visit(L&, R&)
+ * Pairs without a handler and types not in the lists go through the UnknownVisitorPolicy
+ * Operands that have dynamicTypeId() (ie. visitables using MAKE_VISITABLE) are identified by it, other operands
+ * by typeid. Without RTTI every operand must have dynamicTypeId()
+ */
+namespace SUtil {
+	enum class MultiDispatch {
+		asymmetric,
+		symmetric
+	};
+
+	/**
+	 * A handler that can handle the pair (L, R)
+	 */
+	template<typename Handler, typename L, typename R, typename ReturnType>
+	concept MultiVisitorFor = requires(Handler& handler, L& lhs, R& rhs) {
+		{handler.visit(lhs, rhs)} -> std::convertible_to<ReturnType>;
+	};
+
+	/**
+	 * Not for external use
+	 */
+	namespace MultiVisitorTracker {
+		/// T with the constness of Like
+		template<typename Like, typename T>
+		using same_const_t = std::conditional_t<std::is_const_v<Like>, const T, T>;
+	}
+
+	/**
+	 * @param <ReturnType> the return type of the handlers
+	 * @param <Lhs> the possible dynamic types of the left operand
+	 * @param <Rhs> the possible dynamic types of the right operand
+	 * @param <symmetry> whether (L, R) can be handled by visit(R&, L&)
+	 * @param <up> the policy for unhandled pairs
+	 */
+	template<typename ReturnType, TL::TList Lhs, TL::TList Rhs,
+		MultiDispatch symmetry = MultiDispatch::asymmetric,
+		template<typename> typename up = ExceptionUnknownPolicy>
+		requires UnknownVisitorPolicy<up, ReturnType>
+	class MultiVisitor {
+	private:
+		static constexpr std::size_t lhsCount = TL::size<Lhs>();
+		static constexpr std::size_t rhsCount = TL::size<Rhs>();
+
+		template<typename Handler, typename A, typename B>
+		using Entry = ReturnType(*)(Handler&, A&, B&);
+
+		/**
+		 * Handles the pair (L, R) where A and B are the static types of the operands
+		 */
+		template<typename Handler, typename A, typename B, typename L, typename R>
+		static ReturnType entry(Handler& handler, A& lhs, B& rhs) {
+			using LT = MultiVisitorTracker::same_const_t<A, L>;
+			using RT = MultiVisitorTracker::same_const_t<B, R>;
+			if constexpr (MultiVisitorFor<Handler, LT, RT, ReturnType>)
+				return handler.visit(static_cast<LT&>(lhs), static_cast<RT&>(rhs));
+			else
+				return handler.visit(static_cast<RT&>(rhs), static_cast<LT&>(lhs));
+		}
+
+		template<typename Handler, typename A, typename B, typename L, typename R>
+		static constexpr Entry<Handler, A, B> makeEntry() {
+			using LT = MultiVisitorTracker::same_const_t<A, L>;
+			using RT = MultiVisitorTracker::same_const_t<B, R>;
+			// if L isn't derived from A, an A can never have the dynamic type L
+			if constexpr (std::is_base_of_v<std::remove_const_t<A>, L> && std::is_base_of_v<std::remove_const_t<B>, R>) {
+				if constexpr (MultiVisitorFor<Handler, LT, RT, ReturnType> ||
+					(symmetry == MultiDispatch::symmetric && MultiVisitorFor<Handler, RT, LT, ReturnType>))
+					return &entry<Handler, A, B, L, R>;
+			}
+			return [](Handler&, A&, B&) -> ReturnType {
+				return VisitorDispatchTracker::unknownVisit<ReturnType, up>({ typeId<L>() });
+			};
+		}
+
+		template<typename Handler, typename A, typename B, std::size_t ... Is>
+		static constexpr auto makeTable(std::index_sequence<Is...>) {
+			return std::array<Entry<Handler, A, B>, sizeof...(Is)>{
+				makeEntry<Handler, A, B, TL::get_t<Lhs, Is / rhsCount>, TL::get_t<Rhs, Is % rhsCount>>()...
+			};
+		}
+
+		template<typename Handler, typename A, typename B>
+		static constexpr auto table = makeTable<Handler, A, B>(std::make_index_sequence<lhsCount * rhsCount>{});
+	public:
+		/**
+		 * Calls the visit overload of the handler for the dynamic types of lhs and rhs
+		 * @param lhs, rhs polymorphic objects whose dynamic types are in Lhs and Rhs respectively
+		 */
+		template<typename Handler, typename A, typename B>
+			requires std::is_polymorphic_v<A> && std::is_polymorphic_v<B>
+		static ReturnType dispatch(Handler& handler, A& lhs, B& rhs) {
+			const auto l = TL::indexOf<Lhs>(lhs);
+			const auto r = TL::indexOf<Rhs>(rhs);
+			if (l != TL::tl_npos && r != TL::tl_npos) [[likely]]
+				return table<Handler, A, B>[l * rhsCount + r](handler, lhs, rhs);
+			if constexpr (symmetry == MultiDispatch::symmetric) {
+				// lhs may be one of the right types and rhs one of the left types
+				const auto sl = TL::indexOf<Lhs>(rhs);
+				const auto sr = TL::indexOf<Rhs>(lhs);
+				if (sl != TL::tl_npos && sr != TL::tl_npos)
+					return table<Handler, B, A>[sl * rhsCount + sr](handler, rhs, lhs);
+			}
+			return VisitorDispatchTracker::unknownVisit<ReturnType, up>({});
+		}
+	};
+}
+#endif
@@ -0,0 +1,276 @@
+#pragma once
+#ifndef _POLY_COLLECTION_H
+#define _POLY_COLLECTION_H
+#include "ClosedVisitable.hpp"
+#include "TypeList.hpp"
+#include "Visitor.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+/**
+ * Type segregated polymorphic container
+ * Stores every type of the type list in its own contiguous segment, so iteration and visitation
+ * stream through memory instead of following pointers
+ * Usage:
+ *	- PolyCollection<TL::TypeList<A, B, C>> c;
+ *	- auto h = c.emplace<A>(args...); returns a handle that stays valid until the element is erased
+ *	- c.accept(visitor) visits every element, segment by segment. The visitor must be able to visit every type
+ *	- erasing moves the last element of the segment into the hole, so the order within a segment is not kept
+ */
+namespace SUtil {
+	/**
+	 * Stable reference to an element of a PolyCollection
+	 * Stays valid when other elements are inserted or erased
+	 */
+	template<typename T>
+	struct PolyHandle {
+		std::uint32_t slot = std::numeric_limits<std::uint32_t>::max();
+		std::uint32_t generation = 0;
+
+		friend bool operator==(const PolyHandle&, const PolyHandle&) = default;
+	};
+
+	/**
+	 * Not for external use
+	 */
+	namespace PolyCollectionTracker {
+		/**
+		 * Contiguous storage of one type
+		 * Handles refer to slots, a slot stores the index of its element and a generation counter
+		 * which is incremented when its element is erased so that stale handles are detected
+		 */
+		template<typename T>
+		class Segment {
+		private:
+			static constexpr auto npos = std::numeric_limits<std::uint32_t>::max();
+			struct Slot {
+				/// index of the element, or the next free slot if this slot is free
+				std::uint32_t index;
+				std::uint32_t generation;
+			};
+			std::vector<T> items;
+			/// slot of each element
+			std::vector<std::uint32_t> itemSlots;
+			std::vector<Slot> slots;
+			std::uint32_t freeSlot = npos;
+		public:
+			template<typename ... Args>
+			PolyHandle<T> emplace(Args&& ... args) {
+				const auto index = static_cast<std::uint32_t>(items.size());
+				items.emplace_back(std::forward<Args>(args)...);
+				std::uint32_t slot;
+				try {
+					if (freeSlot != npos) {
+						slot = freeSlot;
+						freeSlot = slots[slot].index;
+						slots[slot].index = index;
+					}
+					else {
+						slot = static_cast<std::uint32_t>(slots.size());
+						slots.push_back({ index, 0 });
+					}
+					itemSlots.push_back(slot);
+				}
+				catch (...) {
+					items.pop_back();
+					throw;
+				}
+				return { slot, slots[slot].generation };
+			}
+
+			T* get(PolyHandle<T> handle) noexcept {
+				if (handle.slot >= slots.size() || slots[handle.slot].generation != handle.generation)
+					return nullptr;
+				return &items[slots[handle.slot].index];
+			}
+
+			/**
+			 * Moves the last element into the place of the erased one
+			 * @return false if the handle is stale
+			 */
+			bool erase(PolyHandle<T> handle) {
+				if (!get(handle))
+					return false;
+				auto& slot = slots[handle.slot];
+				const auto last = static_cast<std::uint32_t>(items.size() - 1);
+				if (slot.index != last) {
+					items[slot.index] = std::move(items[last]);
+					itemSlots[slot.index] = itemSlots[last];
+					slots[itemSlots[slot.index]].index = slot.index;
+				}
+				items.pop_back();
+				itemSlots.pop_back();
+				++slot.generation;
+				slot.index = freeSlot;
+				freeSlot = handle.slot;
+				return true;
+			}
+
+			void reserve(std::size_t capacity) {
+				items.reserve(capacity);
+				itemSlots.reserve(capacity);
+				slots.reserve(capacity);
+			}
+
+			void clear() noexcept {
+				// every slot becomes free and stale
+				for (auto slot : itemSlots) {
+					++slots[slot].generation;
+					slots[slot].index = freeSlot;
+					freeSlot = slot;
+				}
+				items.clear();
+				itemSlots.clear();
+			}
+
+			std::span<T> elements() noexcept {
+				return items;
+			}
+
+			std::span<const T> elements() const noexcept {
+				return items;
+			}
+		};
+	}
+
+	template<TL::TList list, typename = std::make_index_sequence<TL::size<list>()>>
+	class PolyCollection;
+
+	/**
+	 * @param <list> the types that can be stored, each type can only appear once
+	 */
+	template<TL::TList list, std::size_t ... Is>
+	class PolyCollection<list, std::index_sequence<Is...>> {
+	public:
+		using Types = list;
+	private:
+		std::tuple<PolyCollectionTracker::Segment<TL::get_t<list, Is>>...> segments;
+
+		template<typename T>
+		static constexpr bool holdsType() {
+			return TL::has<list, T>() && TL::countTypes<list, T>() == 1;
+		}
+
+		template<typename T>
+		auto& segment() noexcept {
+			static_assert(holdsType<T>(), "T must appear exactly once in the type list of the collection");
+			return std::get<TL::find<list, T>()>(segments);
+		}
+
+		template<typename T>
+		const auto& segment() const noexcept {
+			static_assert(holdsType<T>(), "T must appear exactly once in the type list of the collection");
+			return std::get<TL::find<list, T>()>(segments);
+		}
+
+		template<typename T, typename V, typename Segment>
+		static void visitSegment(V& visitor, Segment& segment) {
+			using Visited = std::conditional_t<std::is_const_v<Segment>, const T, T>;
+			using ReturnType = visitor_return_t<V>;
+			using Single = std::conditional_t<std::is_base_of_v<VisitorSingle<Visited, ReturnType>, V>,
+				VisitorSingle<Visited, ReturnType>, VisitorSingle<const T, ReturnType>>;
+			auto& single = static_cast<Single&>(visitor);
+			for (auto& element : segment.elements()) {
+				single.visit(element);
+			}
+		}
+	public:
+		/**
+		 * Constructs a T in its segment
+		 * @return handle to the new element
+		 */
+		template<typename T, typename ... Args>
+		PolyHandle<T> emplace(Args&& ... args) {
+			return segment<T>().emplace(std::forward<Args>(args)...);
+		}
+
+		template<typename T>
+		PolyHandle<std::remove_cvref_t<T>> insert(T&& value) {
+			return emplace<std::remove_cvref_t<T>>(std::forward<T>(value));
+		}
+
+		/**
+		 * Erases the element by moving the last element of its segment into its place
+		 * @return false if the handle does not refer to an element
+		 */
+		template<typename T>
+		bool erase(PolyHandle<T> handle) {
+			return segment<T>().erase(handle);
+		}
+
+		/**
+		 * @return the element referred to by the handle or nullptr if it was erased
+		 */
+		template<typename T>
+		T* get(PolyHandle<T> handle) noexcept {
+			return segment<T>().get(handle);
+		}
+
+		template<typename T>
+		const T* get(PolyHandle<T> handle) const noexcept {
+			return const_cast<PolyCollection*>(this)->get(handle);
+		}
+
+		/**
+		 * Reserves space for capacity elements of type T
+		 */
+		template<typename T>
+		void reserve(std::size_t capacity) {
+			segment<T>().reserve(capacity);
+		}
+
+		/**
+		 * @return the contiguous elements of type T
+		 */
+		template<typename T>
+		std::span<T> elements() noexcept {
+			return segment<T>().elements();
+		}
+
+		template<typename T>
+		std::span<const T> elements() const noexcept {
+			return segment<T>().elements();
+		}
+
+		template<typename T>
+		std::size_t size() const noexcept {
+			return segment<T>().elements().size();
+		}
+
+		std::size_t size() const noexcept {
+			return (std::get<Is>(segments).elements().size() + ... + 0);
+		}
+
+		bool empty() const noexcept {
+			return size() == 0;
+		}
+
+		/**
+		 * Erases all elements, all handles become stale
+		 */
+		void clear() noexcept {
+			(std::get<Is>(segments).clear(), ...);
+		}
+
+		/**
+		 * Visits every element, one segment at a time in the order of the type list
+		 * Results of non void visit functions are discarded
+		 */
+		template<typename V>
+			requires ClosedVisitorOf<V, list, visitor_return_t<V>>
+		void accept(V& visitor) {
+			(visitSegment<TL::get_t<list, Is>>(visitor, std::get<Is>(segments)), ...);
+		}
+
+		template<typename V>
+			requires ConstClosedVisitorOf<V, list, visitor_return_t<V>>
+		void accept(V& visitor) const {
+			(visitSegment<TL::get_t<list, Is>>(visitor, std::get<Is>(segments)), ...);
+		}
+	};
+}
+#endif
@@ -0,0 +1,568 @@
+#pragma once
+#ifndef _SERIALIZATION_H
+#define _SERIALIZATION_H
+#include "Arena.hpp"
+#include "TypeId.hpp"
+#include "TypeList.hpp"
+#include "Visitor.hpp"
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#if __has_include(<sys/uio.h>)
+#include <sys/uio.h>
+#define SUTIL_HAS_IOVEC 1
+#else
+#define SUTIL_HAS_IOVEC 0
+#endif
+/**
+ * Binary serialization of visitable hierarchies
+ * Usage:
+ *	- list the serializable types in a TL::TypeList. The index of a type in the list is its id in the format,
+ *		so only append to the list to stay compatible with existing data
+ *	- give each type a void serialize(BinaryWriter&) const function that writes its fields, and a constructor
+ *		taking a BinaryReader& that reads them back in the same order
+ *	- children are written with writer.writeObject(child) and read with reader.readObject<Root>()
+ *	- SerializeVisitor<Root, Types> writes into a caller provided buffer or list of iovecs without allocating.
+ *		If the output is too small, the rest is dropped and size() is the size the output needed to be
+ *	- Deserializer<Root, Types> builds the objects in an Arena, strings and arrays are copied into the arena.
+ *		Objects are read recursively, so input nested deeper than its maxDepth is rejected
+ * Root is the class all listed types derive from, and the static type of the objects that are written and read.
+ * Root must have dynamicTypeId() (see MAKE_VISITABLE)
+ * Format, all integers are little endian:
+ *	- object: u32 index of the type in Types, u32 length of the payload, payload
+ *	- null object: u32 0xFFFFFFFF
+ *	- bool: u8, integers and enums: their size, floating point: their IEEE 754 bits
+ *	- string: u32 length, bytes. array: u32 count, elements
+ * A reader that reads less than the payload of an object skips the rest, so fields can be appended to a type
+ */
+namespace SUtil {
+#if SUTIL_HAS_IOVEC
+	using IoVec = ::iovec;
+#else
+	struct IoVec {
+		void* iov_base;
+		std::size_t iov_len;
+	};
+#endif
+
+	class SerializationException : public std::exception {
+	private:
+		const char* message;
+	public:
+		explicit SerializationException(const char* message) noexcept : message(message) {}
+
+		const char* what() const noexcept override {
+			return message;
+		}
+	};
+
+	/**
+	 * Not for external use
+	 */
+	namespace SerializationTracker {
+		constexpr inline std::uint32_t nullIndex = 0xFFFFFFFF;
+		/// how deeply objects may be nested in the input before reading them would risk the stack
+		constexpr inline std::uint32_t defaultMaxDepth = 256;
+
+		template<typename T>
+		concept Scalar = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+		/**
+		 * @return the unsigned integer that is written for the scalar
+		 */
+		template<Scalar T>
+		constexpr auto toBits(T value) noexcept {
+			if constexpr (std::is_enum_v<T>)
+				return toBits(static_cast<std::underlying_type_t<T>>(value));
+			else if constexpr (std::is_same_v<T, bool>)
+				return static_cast<std::uint8_t>(value ? 1 : 0);
+			else if constexpr (std::is_floating_point_v<T>) {
+				static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Only 32 and 64 bit floating point types are supported");
+				using Bits = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+				return std::bit_cast<Bits>(value);
+			}
+			else
+				return static_cast<std::make_unsigned_t<T>>(value);
+		}
+
+		template<Scalar T>
+		using bits_t = decltype(toBits(std::declval<T>()));
+
+		template<Scalar T, typename Bits>
+		constexpr T fromBits(Bits bits) noexcept {
+			if constexpr (std::is_enum_v<T>)
+				return static_cast<T>(fromBits<std::underlying_type_t<T>>(bits));
+			else if constexpr (std::is_same_v<T, bool>)
+				return bits != 0;
+			else if constexpr (std::is_floating_point_v<T>)
+				return std::bit_cast<T>(bits);
+			else
+				return static_cast<T>(bits);
+		}
+
+		/// scalars whose memory is already in the format, so arrays of them can be copied at once
+		template<typename T>
+		constexpr inline bool rawCopyable = std::endian::native == std::endian::little &&
+			Scalar<T> && !std::is_same_v<T, bool> && sizeof(T) == sizeof(bits_t<T>);
+	}
+
+	class BinaryReader;
+
+	/**
+	 * Writes scalars, strings and objects into the output of a SerializeVisitor
+	 */
+	class BinaryWriter {
+	private:
+		/// the segment of a contiguous output
+		IoVec single{};
+		const IoVec* segments;
+		std::size_t segmentCount;
+		std::size_t segment = 0;
+		/// offset in the current segment
+		std::size_t offset = 0;
+		std::size_t total = 0;
+		bool overflow = false;
+
+		/// writes a Root of the serializer, the serializer is passed as the context
+		using WriteObject = void(*)(void*, const void*);
+		void* context;
+		WriteObject writeRoot;
+		TypeId root;
+
+		template<typename Root, typename Types>
+		friend class SerializeVisitor;
+
+		BinaryWriter(std::span<std::byte> buffer, void* context, WriteObject writeRoot, TypeId root) noexcept :
+			single{ buffer.data(), buffer.size() }, segments(&single), segmentCount(1),
+			context(context), writeRoot(writeRoot), root(root) {}
+
+		BinaryWriter(std::span<const IoVec> buffers, void* context, WriteObject writeRoot, TypeId root) noexcept :
+			segments(buffers.data()), segmentCount(buffers.size()), context(context), writeRoot(writeRoot), root(root) {}
+
+		/**
+		 * Overwrites bytes that were written at position
+		 */
+		void patch(std::size_t position, const std::byte* bytes, std::size_t size) noexcept {
+			std::size_t start = 0;
+			for (std::size_t i = 0; i < segmentCount && size > 0; ++i) {
+				const auto length = segments[i].iov_len;
+				if (position < start + length) {
+					const auto at = position - start;
+					const auto count = std::min(size, length - at);
+					std::memcpy(static_cast<std::byte*>(segments[i].iov_base) + at, bytes, count);
+					bytes += count;
+					position += count;
+					size -= count;
+				}
+				start += length;
+			}
+		}
+
+		void writeLength(std::size_t length) {
+			if (length > std::numeric_limits<std::uint32_t>::max())
+				throw SerializationException("Serialized string or array is too long");
+			write(static_cast<std::uint32_t>(length));
+		}
+
+		std::size_t beginObject(std::uint32_t index) {
+			write(index);
+			const auto position = total;
+			write(std::uint32_t{ 0 });
+			return position;
+		}
+
+		void endObject(std::size_t position) {
+			const auto length = total - position - sizeof(std::uint32_t);
+			if (length > std::numeric_limits<std::uint32_t>::max())
+				throw SerializationException("Serialized object is too large");
+			std::array<std::byte, sizeof(std::uint32_t)> bytes;
+			for (std::size_t i = 0; i < bytes.size(); ++i)
+				bytes[i] = static_cast<std::byte>(length >> (8 * i));
+			patch(position, bytes.data(), bytes.size());
+		}
+	public:
+		BinaryWriter(const BinaryWriter&) = delete;
+		BinaryWriter& operator=(const BinaryWriter&) = delete;
+
+		/**
+		 * Copies the bytes into the output, as far as they fit
+		 */
+		void writeBytes(const void* data, std::size_t size) noexcept {
+			auto* bytes = static_cast<const std::byte*>(data);
+			total += size;
+			while (size > 0 && segment < segmentCount) {
+				const auto count = std::min(size, segments[segment].iov_len - offset);
+				std::memcpy(static_cast<std::byte*>(segments[segment].iov_base) + offset, bytes, count);
+				bytes += count;
+				size -= count;
+				offset += count;
+				if (offset == segments[segment].iov_len) {
+					++segment;
+					offset = 0;
+				}
+			}
+			overflow |= size > 0;
+		}
+
+		template<SerializationTracker::Scalar T>
+		void write(T value) noexcept {
+			const auto bits = SerializationTracker::toBits(value);
+			std::array<std::byte, sizeof(bits)> bytes;
+			for (std::size_t i = 0; i < bytes.size(); ++i)
+				bytes[i] = static_cast<std::byte>(bits >> (8 * i));
+			writeBytes(bytes.data(), bytes.size());
+		}
+
+		void write(std::string_view string) {
+			writeLength(string.size());
+			writeBytes(string.data(), string.size());
+		}
+
+		template<SerializationTracker::Scalar T>
+		void writeArray(std::span<const T> values) {
+			writeLength(values.size());
+			if constexpr (SerializationTracker::rawCopyable<T>)
+				writeBytes(values.data(), values.size_bytes());
+			else {
+				for (auto value : values)
+					write(value);
+			}
+		}
+
+		/**
+		 * Writes the object as an object of its dynamic type
+		 * @param obj a pointer to the Root of the serializer, may be nullptr
+		 * @throw SerializationException if the dynamic type isn't one of the serializable types
+		 */
+		template<typename Root>
+		void writeObject(const Root* obj) {
+			if (typeId<Root>() != root)
+				throw SerializationException("Objects must be written as the Root of the serializer");
+			if (!obj)
+				write(SerializationTracker::nullIndex);
+			else
+				writeRoot(context, obj);
+		}
+
+		template<typename Root>
+			requires (!std::is_pointer_v<Root>)
+		void writeObject(const Root& obj) {
+			writeObject(&obj);
+		}
+
+		/**
+		 * @return the amount of bytes written, including those that did not fit
+		 */
+		std::size_t size() const noexcept {
+			return total;
+		}
+
+		/**
+		 * @return true if the output was too small
+		 */
+		bool overflowed() const noexcept {
+			return overflow;
+		}
+	};
+
+	/**
+	 * A serializable type
+	 */
+	template<typename T>
+	concept BinarySerializable = std::constructible_from<T, BinaryReader&> &&
+		requires(const T& obj, BinaryWriter& writer) {
+		obj.serialize(writer);
+	};
+
+	template<typename Root, typename Types>
+	class SerializeVisitor;
+
+	namespace SerializationTracker {
+		template<typename Self, typename Base, typename ... Ts>
+		class VisitLinks;
+
+		template<typename Self, typename Base>
+		class VisitLinks<Self, Base> : public Base {};
+
+		/**
+		 * Implements visit(const T&) of the Visitor base of a SerializeVisitor, one type per link
+		 */
+		template<typename Self, typename Base, typename T, typename ... Ts>
+		class VisitLinks<Self, Base, T, Ts...> : public VisitLinks<Self, Base, Ts...> {
+		public:
+			void visit(const T& obj) override {
+				static_cast<Self&>(*this).visitObject(obj);
+			}
+		};
+	}
+
+	/**
+	 * Writes objects in the binary format
+	 * Also a visitor of the const Types, so root.accept(serializer) works for hierarchies returning void
+	 * @param <Root> the common parent of Types
+	 * @param <Types> TL::TypeList of the serializable types
+	 */
+	template<typename Root, typename ... Ts>
+	class SerializeVisitor<Root, TL::TypeList<Ts...>> : public SerializationTracker::VisitLinks<
+		SerializeVisitor<Root, TL::TypeList<Ts...>>, Visitor<void, const Ts...>, Ts...> {
+		static_assert((std::is_base_of_v<Root, Ts> && ...), "Every serializable type must derive from Root");
+		static_assert((BinarySerializable<Ts> && ...),
+			"Serializable types need a serialize(BinaryWriter&) const function and a constructor from a BinaryReader&");
+		static_assert(DynamicTypeIdentifiable<Root>, "Root must have dynamicTypeId()");
+		using Types = TL::TypeList<Ts...>;
+	private:
+		BinaryWriter out;
+
+		template<typename, typename, typename ...>
+		friend class SerializationTracker::VisitLinks;
+
+		template<typename T>
+		void writeAs(const Root& obj) {
+			visitObject(static_cast<const T&>(obj));
+		}
+
+		template<typename T>
+		void visitObject(const T& obj) {
+			const auto position = out.beginObject(static_cast<std::uint32_t>(TL::find<Types, T>()));
+			obj.serialize(out);
+			out.endObject(position);
+		}
+
+		static void writeRoot(void* self, const void* obj) {
+			const auto& root = *static_cast<const Root*>(obj);
+			const auto index = TL::indexOf<Types>(root);
+			if (index == TL::tl_npos)
+				throw SerializationException("The type of the object is not serializable");
+			using Write = void (SerializeVisitor::*)(const Root&);
+			static constexpr std::array<Write, sizeof...(Ts)> writers{ &SerializeVisitor::writeAs<Ts>... };
+			(static_cast<SerializeVisitor*>(self)->*writers[index])(root);
+		}
+	public:
+		/**
+		 * Writes into a contiguous buffer
+		 */
+		explicit SerializeVisitor(std::span<std::byte> buffer) noexcept :
+			out(buffer, this, &writeRoot, typeId<Root>()) {}
+
+		/**
+		 * Writes into the buffers one after the other, like writev()
+		 */
+		explicit SerializeVisitor(std::span<const IoVec> buffers) noexcept :
+			out(buffers, this, &writeRoot, typeId<Root>()) {}
+
+		SerializeVisitor(const SerializeVisitor&) = delete;
+		SerializeVisitor& operator=(const SerializeVisitor&) = delete;
+
+		/**
+		 * Appends the object to the output
+		 */
+		void write(const Root& obj) {
+			out.writeObject(&obj);
+		}
+
+		BinaryWriter& writer() noexcept {
+			return out;
+		}
+
+		std::size_t size() const noexcept {
+			return out.size();
+		}
+
+		bool overflowed() const noexcept {
+			return out.overflowed();
+		}
+	};
+
+	/**
+	 * Reads scalars, strings and objects from the input of a Deserializer
+	 * @throw SerializationException when the input is malformed
+	 */
+	class BinaryReader {
+	private:
+		const std::byte* data;
+		/// end of the current object
+		std::size_t limit;
+		std::size_t position = 0;
+		Arena& storage;
+
+		/// reads a Root of the deserializer
+		using ReadObject = void*(*)(BinaryReader&, std::uint32_t);
+		ReadObject readRoot;
+		TypeId root;
+		std::uint32_t typeCount;
+		/// number of objects being read
+		std::uint32_t depth = 0;
+		std::uint32_t maxDepth;
+
+		template<typename Root, typename Types>
+		friend class Deserializer;
+
+		BinaryReader(std::span<const std::byte> input, Arena& storage, ReadObject readRoot, TypeId root,
+			std::uint32_t typeCount, std::uint32_t maxDepth) noexcept :
+			data(input.data()), limit(input.size()), storage(storage), readRoot(readRoot), root(root),
+			typeCount(typeCount), maxDepth(maxDepth) {}
+
+		const std::byte* take(std::size_t size) {
+			if (size > limit - position)
+				throw SerializationException("Serialized data is truncated");
+			const auto* bytes = data + position;
+			position += size;
+			return bytes;
+		}
+	public:
+		BinaryReader(const BinaryReader&) = delete;
+		BinaryReader& operator=(const BinaryReader&) = delete;
+
+		void readBytes(void* out, std::size_t size) {
+			std::memcpy(out, take(size), size);
+		}
+
+		template<SerializationTracker::Scalar T>
+		T read() {
+			using Bits = SerializationTracker::bits_t<T>;
+			const auto* bytes = take(sizeof(Bits));
+			Bits bits = 0;
+			for (std::size_t i = 0; i < sizeof(Bits); ++i)
+				bits |= static_cast<Bits>(static_cast<Bits>(bytes[i]) << (8 * i));
+			return SerializationTracker::fromBits<T>(bits);
+		}
+
+		/**
+		 * @return a copy of the string in the arena
+		 */
+		std::string_view readString() {
+			const auto size = read<std::uint32_t>();
+			const auto* bytes = take(size);
+			auto chars = storage.allocateArray<char>(size);
+			std::memcpy(chars.data(), bytes, size);
+			return { chars.data(), size };
+		}
+
+		/**
+		 * @return a copy of the array in the arena
+		 */
+		template<SerializationTracker::Scalar T>
+		std::span<T> readArray() {
+			const auto count = read<std::uint32_t>();
+			if (count > (limit - position) / sizeof(SerializationTracker::bits_t<T>))
+				throw SerializationException("Serialized data is truncated");
+			auto values = storage.allocateArray<T>(count);
+			if constexpr (SerializationTracker::rawCopyable<T>)
+				std::memcpy(values.data(), take(values.size_bytes()), values.size_bytes());
+			else {
+				for (auto& value : values)
+					value = read<T>();
+			}
+			return values;
+		}
+
+		/**
+		 * Builds the next object in the arena
+		 * @return the object or nullptr if a null object was written
+		 */
+		template<typename Root>
+		Root* readObject() {
+			if (typeId<Root>() != root)
+				throw SerializationException("Objects must be read as the Root of the deserializer");
+			const auto index = read<std::uint32_t>();
+			if (index == SerializationTracker::nullIndex)
+				return nullptr;
+			if (index >= typeCount)
+				throw SerializationException("Unknown serialized type");
+			if (depth == maxDepth)
+				throw SerializationException("Serialized objects are nested too deeply");
+			const auto length = read<std::uint32_t>();
+			if (length > limit - position)
+				throw SerializationException("Serialized data is truncated");
+			const auto end = position + length;
+			const auto outer = std::exchange(limit, end);
+			++depth;
+			auto* obj = static_cast<Root*>(readRoot(*this, index));
+			--depth;
+			// skip the fields that the type no longer reads
+			position = end;
+			limit = outer;
+			return obj;
+		}
+
+		/**
+		 * @return the arena the objects are built in
+		 */
+		Arena& arena() noexcept {
+			return storage;
+		}
+
+		/**
+		 * @return true if the whole input (or the current object) has been read
+		 */
+		bool done() const noexcept {
+			return position == limit;
+		}
+
+		std::size_t offset() const noexcept {
+			return position;
+		}
+	};
+
+	template<typename Root, typename Types>
+	class Deserializer;
+
+	/**
+	 * Reads objects written by a SerializeVisitor with the same Root and Types
+	 */
+	template<typename Root, typename ... Ts>
+	class Deserializer<Root, TL::TypeList<Ts...>> {
+		static_assert((std::is_base_of_v<Root, Ts> && ...), "Every serializable type must derive from Root");
+	private:
+		BinaryReader in;
+
+		static void* readRoot(BinaryReader& in, std::uint32_t index) {
+			using Read = Root* (*)(BinaryReader&);
+			static constexpr std::array<Read, sizeof...(Ts)> readers{
+				[](BinaryReader& in) -> Root* { return in.arena().template create<Ts>(in); }...
+			};
+			return readers[index](in);
+		}
+	public:
+		/**
+		 * @param input must outlive the deserializer, but not the objects
+		 * @param arena where the objects are built
+		 * @param maxDepth how many objects may be nested in each other, deeper input throws a SerializationException
+		 */
+		Deserializer(std::span<const std::byte> input, Arena& arena,
+			std::uint32_t maxDepth = SerializationTracker::defaultMaxDepth) noexcept :
+			in(input, arena, &readRoot, typeId<Root>(), static_cast<std::uint32_t>(sizeof...(Ts)), maxDepth) {}
+
+		Deserializer(const Deserializer&) = delete;
+		Deserializer& operator=(const Deserializer&) = delete;
+
+		/**
+		 * Reads the next object of the input
+		 * @return the object or nullptr if a null object was written
+		 */
+		Root* read() {
+			return in.readObject<Root>();
+		}
+
+		/**
+		 * @return true if every object of the input has been read
+		 */
+		bool done() const noexcept {
+			return in.done();
+		}
+
+		BinaryReader& reader() noexcept {
+			return in;
+		}
+	};
+}
+#endif
@@ -6,6 +6,20 @@
 #include <mutex>
 #include <compare>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <future>
+#include <limits>
+#include <new>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
 /**
  * Singleton Utility:
  * Policies:
@@ -15,11 +29,35 @@
  *	-	DestructionPolicy - how to schedule the destruction of the singleton
  *		- Standard: use c++ automatic cleanup semantics
  *		- Lifetime: manually set a numeric lifetime number. Singletons with larger lifetimes are destroyed later
+ *			Singletons with the same lifetime are destroyed in the order they were created
  *	-	LockingPolicy - how to lock the singleton (not the actual object in the singleton)
  *		- LockGuard - use a lock
+ *		- FutexLock - a lock that waits with std::atomic::wait, smaller than a mutex
+ *		- CallOnce - std::call_once, falls back to a lock when the singleton is revived
  *		- NoLock - don't use a lock
+ *		- the lock is only taken to create the object. Once created, get() is a single acquire load
+ *	-	AccessPolicy - how get() gives access to the object in the singleton
+ *		- DirectAccess - get() returns a reference, the object must synchronize itself
+ *		- MutexAccess - get() returns a proxy holding a std::mutex
+ *		- SharedMutexAccess - get() returns a proxy holding a std::shared_mutex exclusively, read() one holding it shared
+ *		- SeqLockAccess - get() returns a proxy to a copy of the object that is published when the proxy is destroyed,
+ *			read() returns a consistent copy without locking. For small trivially copyable objects
+ *		- SpinLockAccess - get() returns a proxy holding a spin lock with exponential backoff
+ *		- proxies are used like pointers (ie. Singleton::get()->member) and hold the lock until they are destroyed
  *	-	CreatePolicy - how to delete/create the object in the singleton
  *		- FreeStore - use the free store (C++ new/delete)
+ *		- StaticStorage - construct the object in a static, cache line aligned buffer
+ *		- ConstantInit - the object is constant initialized (constinit), so it exists before any code runs
+ *			and get() never has to create it. Requires T to be constexpr default constructible
+ *		- SingletonFamily - see SingletonFamily.hpp
+ *	-	InstrumentationPolicy - what is measured about the lifecycle of the singleton
+ *		- NoInstrumentation - nothing, get() is not changed at all
+ *		- SingletonTelemetry - see SingletonTelemetry.hpp
+ * Asynchronous creation (opt-in, see AsyncSingleton):
+ *	- AsyncSingleton<Single>::prefetch() starts creating (or reviving) the object on another thread,
+ *		Single::get() waits for it on the lock of the locking policy
+ *	- AsyncSingleton<Single>::getAsync() returns a std::shared_future of the object
+ *	- the thread creating the object is joined at exit
  */
 namespace SUtil {
 	template<typename T>
@@ -40,11 +78,41 @@ namespace SUtil {
 		{T::scheduleDestruction(std::declval<void(*)()>())};
 	};
 
+	/**
+	 * Requires either a lockSingleton() function returning a guard held while the singleton is created,
+	 * or an initializeOnce(init) function that calls init and excludes concurrent calls
+	 */
 	template<typename T>
 	concept SingletonLockPolicy = requires(T a) {
 		T::lockSingleton();
+	} || requires(void(*init)()) {
+		T::initializeOnce(init);
+	};
+
+	/**
+	 * Requires an access(obj) function whose result is returned by get()
+	 * read(obj) is optional, it is returned by read() if present
+	 */
+	template<template <typename> typename T, typename R>
+	concept SingletonAccessPolicy = requires(R& obj) {
+		T<R>::access(obj);
 	};
 
+	/**
+	 * Requires a constexpr enabled flag. If it is set, the hooks are called with the time each step took:
+	 * onGet() by every get(), onLock(waited) once the lock of the locking policy is acquired,
+	 * onCreate(time) after the object is created and onDestroy(time) after it is destroyed
+	 */
+	template<template <typename> typename T, typename R>
+	concept SingletonInstrumentationPolicy = requires {
+		{T<R>::enabled} -> std::convertible_to<bool>;
+	} && (!T<R>::enabled || requires(std::chrono::nanoseconds time) {
+		T<R>::onGet();
+		T<R>::onLock(time);
+		T<R>::onCreate(time);
+		{T<R>::onDestroy(time)} noexcept;
+	});
+
 	class DeadReferenceException : public std::exception {
 	public:
 		const char* what() const noexcept override {
@@ -77,101 +145,147 @@ namespace SUtil {
 			/// Invariant: destroyer does not throw
 			void(*destroyer)(void); 
 			unsigned longevity;
+			/// order of registration, singletons with the same longevity are destroyed in the order they were registered
+			unsigned long long sequence;
+			/// not a singleton, but a function that runs after every singleton in the heap
+			bool last = false;
 		};
-		auto operator<=>(const SingletonLife& s1, const SingletonLife& s2) {
-			return s1.longevity <=> s2.longevity;
+		inline auto operator<=>(const SingletonLife& s1, const SingletonLife& s2) {
+			if (auto order = s1.longevity <=> s2.longevity; order != 0)
+				return order;
+			if (auto order = s1.last <=> s2.last; order != 0)
+				return order;
+			return s1.sequence <=> s2.sequence;
 		}
-		/// array of SingletonLife* ordered highest to shortest longevity
-		inline SingletonLife** lifetimeManager = nullptr;
-		/// number of elements in lifetimeManager
-		inline int lifetimeElements = 0;
+
+		/// singletons that can be scheduled before the heap is moved to the C heap
+		constexpr inline std::size_t reservedLives = 256;
 
 		/**
-		 * Pops the last element in the array
+		 * Min heap of the scheduled singletons, the shortest longevity is destroyed first
+		 * All of it is constant initialized so that it can be used during the initialization of other globals
 		 */
-		inline void popLifetimeArray() noexcept {
-			auto last = lifetimeManager[lifetimeElements - 1];
-			if (--lifetimeElements > 0) {
-				lifetimeManager = static_cast<SingletonLife**>(
-					realloc(lifetimeManager, sizeof(SingletonLife*) * (lifetimeElements)));
-				// this should not fail because lifetimeElements is less than it was
+		struct LifetimeHeap {
+			SingletonLife reserved[reservedLives]{};
+			SingletonLife* lives = reserved;
+			std::size_t size = 0;
+			std::size_t capacity = reservedLives;
+			unsigned long long sequence = 0;
+			/// true while the destroyAll handler is registered with atexit and hasn't finished
+			bool registered = false;
+			std::atomic_flag busy;
+
+			void lock() noexcept {
+				while (busy.test_and_set(std::memory_order_acquire))
+					busy.wait(true, std::memory_order_relaxed);
 			}
-			else {
-				free(lifetimeManager);
-				// realloc is not guartunteed to act like free when size is 0, although it does on many implementations
+			void unlock() noexcept {
+				busy.clear(std::memory_order_release);
+				busy.notify_one();
 			}
-			last->destroyer();
-			free(last);
-		}
-		/**
-		 * @return the position the element with the specified longevity should go
-		 */
-		inline auto posForLongevity(unsigned longevity) {
-			auto i = 0;
-			for (; i < lifetimeElements; ++i) {
-				if (lifetimeManager[i]->longevity <= longevity)
-					break;
+
+			static bool later(const SingletonLife& a, const SingletonLife& b) noexcept {
+				return a > b;
 			}
-			return i;
-		}
+
+			/**
+			 * Ensures that count singletons fit without growing, throws std::bad_alloc on failure
+			 */
+			void reserve(std::size_t count) {
+				if (count <= capacity)
+					return;
+				auto* grown = static_cast<SingletonLife*>(malloc(sizeof(SingletonLife) * count));
+				if (grown == nullptr) throw std::bad_alloc();
+				std::copy(lives, lives + size, grown);
+				if (lives != reserved)
+					free(lives);
+				lives = grown;
+				capacity = count;
+			}
+		};
+		inline constinit LifetimeHeap lifetimeManager;
+
 		/**
-		 * Creates space in the lifetimeManager array for an element at posToClear
-		 * Shifts all elements after the given position to the right
-		 * requires the last element to be empty and there to be lifeElements + 1 spaces in the array
+		 * The one atexit handler, destroys the singletons from shortest to highest longevity
+		 * Singletons scheduled while it runs (ie. revived by a destructor) are destroyed by it too
 		 */
-		inline void shiftLifetimeElements(int posToClear) {
-			if (posToClear < lifetimeElements) { // if not the last element (nothing to shift)
-				for (auto i = lifetimeElements; i >= posToClear; --i) {
-					lifetimeManager[i + 1] = lifetimeManager[i];
+		inline void destroyAll() noexcept {
+			auto& heap = lifetimeManager;
+			for (;;) {
+				heap.lock();
+				if (heap.size == 0) {
+					heap.registered = false;
+					if (heap.lives != heap.reserved) {
+						free(heap.lives);
+						heap.lives = heap.reserved;
+						heap.capacity = reservedLives;
+					}
+					heap.unlock();
+					return;
 				}
+				std::pop_heap(heap.lives, heap.lives + heap.size, &LifetimeHeap::later);
+				auto destroyer = heap.lives[--heap.size].destroyer;
+				heap.unlock();
+				destroyer();
 			}
 		}
+
 		/**
-		 * Adds the singleton life manager to the array and cleans up on error
+		 * Adds the singleton to the heap in O(log n), amortized O(1) allocations
+		 * If it cannot be scheduled, the singleton is destroyed immediately
 		 */
-		inline void safeAddManagerToArray(SingletonLife* manager) {
-			int pos = 0;
-			try {
-				int p = manager->longevity;
-				pos = posForLongevity(manager->longevity);
-				shiftLifetimeElements(pos);
-			}
-			catch (const std::exception& e) {
-				free(manager);
-				throw e;
-			}
-			++lifetimeElements;
-			lifetimeManager[pos] = manager;
-			atexit(&popLifetimeArray);
-		}
-		inline void _scheduleDestruction(const SingletonLife & singleton) {
-			auto newArray = 
-				static_cast<SingletonLife**>(
-					realloc(lifetimeManager, sizeof(SingletonLife*) * (lifetimeElements + 1)));
-			// not incrementing lifetimeElements yet so that if this call fails, retain the strong guaruntee
-			if (newArray == nullptr) throw std::bad_alloc();
-			else lifetimeManager = newArray;
-
-			auto newLifeManager = static_cast<SingletonLife*>(malloc(sizeof(SingletonLife)));
-			newLifeManager->destroyer = singleton.destroyer;
-			newLifeManager->longevity = singleton.longevity;
-			safeAddManagerToArray(newLifeManager);
-			
-		}
 		inline void scheduleDestruction(SingletonLife singleton) {
+			auto& heap = lifetimeManager;
+			heap.lock();
 			try {
-				_scheduleDestruction(singleton);
+				if (heap.size == heap.capacity)
+					heap.reserve(heap.capacity * 2);
+				if (!heap.registered) {
+					if (std::atexit(&destroyAll) != 0) throw std::bad_alloc();
+					heap.registered = true;
+				}
 			}
 			catch (...) {
+				heap.unlock();
 				singleton.destroyer();
+				return;
 			}
+			singleton.sequence = heap.sequence++;
+			heap.lives[heap.size++] = singleton;
+			std::push_heap(heap.lives, heap.lives + heap.size, &LifetimeHeap::later);
+			heap.unlock();
+		}
+
+		/**
+		 * Schedules a function that does not throw to run once every singleton in the heap has been destroyed,
+		 * including singletons scheduled after it
+		 */
+		inline void scheduleLast(void(*last)(void)) {
+			scheduleDestruction({ last, std::numeric_limits<unsigned>::max(), 0, true });
 		}
 	}
 
+	/**
+	 * Reserves room for count singletons with a LongevityDestructionPolicy, so that scheduling them never allocates
+	 * Space for the first 256 is always reserved
+	 */
+	inline void reserveLifetimeSingletons(std::size_t count) {
+		auto& heap = SingletonLongevityTracker::lifetimeManager;
+		heap.lock();
+		try {
+			heap.reserve(count);
+		}
+		catch (...) {
+			heap.unlock();
+			throw;
+		}
+		heap.unlock();
+	}
+
 	template<unsigned longevity>
 	struct LongevityDestructionPolicy {
 		static void scheduleDestruction(void(*destroyer)(void)) {
-			SingletonLongevityTracker::scheduleDestruction({ destroyer, longevity });
+			SingletonLongevityTracker::scheduleDestruction({ destroyer, longevity, 0 });
 		}
 	};
 
@@ -185,11 +299,318 @@ namespace SUtil {
 		}
 	};
 
+	/**
+	 * Not for external use
+	 */
+	namespace SingletonStorageTracker {
+		/// the storage of the object is padded to this so that it does not share a cache line with other data
+		constexpr inline std::size_t cacheLine = 64;
+
+		template<typename T>
+		constexpr inline std::size_t storageAlignment = std::max(alignof(T), cacheLine);
+	}
+
+	/**
+	 * Constructs the object in a static buffer instead of on the heap
+	 * The buffer is reused when the singleton is revived
+	 */
+	template<typename T>
+	struct StaticStorageCreatePolicy {
+	private:
+		struct alignas(SingletonStorageTracker::storageAlignment<T>) Storage {
+			std::byte bytes[sizeof(T)];
+		};
+		static inline Storage storage;
+	public:
+		static T* create() {
+			return ::new (static_cast<void*>(storage.bytes)) T();
+		}
+		static void free(T* instance) noexcept {
+			if (instance)
+				instance->~T();
+		}
+	};
+
+	/**
+	 * Constant initializes the object in a static buffer, so the singleton is already created when the program starts
+	 * The object is destroyed by the DestructionPolicy like any other singleton, a revived object is reconstructed
+	 * at runtime in the same buffer
+	 */
+	template<typename T>
+	struct ConstantInitCreatePolicy {
+	private:
+		union alignas(SingletonStorageTracker::storageAlignment<T>) Storage {
+			T object;
+			constexpr Storage() : object() {}
+			/// the object is destroyed by free(), not when the program exits
+			constexpr ~Storage() {}
+		};
+		static inline constinit Storage storage;
+	public:
+		/**
+		 * @return the object that exists before the singleton is first used
+		 */
+		static constexpr T* initialInstance() noexcept {
+			return &storage.object;
+		}
+		static T* create() {
+			return ::new (static_cast<void*>(&storage.object)) T();
+		}
+		static void free(T* instance) noexcept {
+			if (instance)
+				instance->~T();
+		}
+	};
+
 	template<typename T>
 	struct SingletonLockGuard {
-		static std::mutex mu;
-		static std::lock_guard<std::mutex> lockSingleton() {
-			return { mu };
+		static inline std::mutex mu;
+		static std::unique_lock<std::mutex> lockSingleton() {
+			return std::unique_lock<std::mutex>(mu);
+		}
+	};
+
+	/**
+	 * A one byte lock, waiters sleep in std::atomic::wait (a futex on Linux) instead of on a mutex
+	 */
+	template<typename T>
+	struct SingletonFutexLock {
+		static inline std::atomic<bool> locked{ false };
+
+		class Guard {
+		public:
+			Guard() noexcept {
+				while (locked.exchange(true, std::memory_order_acquire))
+					locked.wait(true, std::memory_order_relaxed);
+			}
+			~Guard() {
+				locked.store(false, std::memory_order_release);
+				locked.notify_all();
+			}
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+		};
+
+		static Guard lockSingleton() noexcept {
+			return {};
+		}
+	};
+
+	/**
+	 * Creates the singleton with std::call_once
+	 * A once_flag cannot be reset, so reviving a destroyed singleton takes a mutex instead
+	 */
+	template<typename T>
+	struct SingletonCallOnce {
+		static inline std::once_flag once;
+		static inline std::mutex revival;
+
+		template<typename F>
+		static void initializeOnce(F&& init) {
+			bool called = false;
+			std::call_once(once, [&]() {
+				called = true;
+				init();
+			});
+			if (!called) {
+				std::lock_guard<std::mutex> lk(revival);
+				init();
+			}
+		}
+	};
+
+	/**
+	 * Not for external use
+	 */
+	namespace SingletonAccessTracker {
+		inline void cpuRelax() noexcept {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+			__builtin_ia32_pause();
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+			asm volatile("yield");
+#endif
+		}
+
+		/**
+		 * Test and test and set lock, a waiter doubles the time it spins between attempts and yields its time slice
+		 * once that reaches maxBackoff
+		 */
+		class BackoffSpinLock {
+		private:
+			static constexpr unsigned maxBackoff = 1024;
+			std::atomic<bool> locked{ false };
+		public:
+			void lock() noexcept {
+				for (unsigned backoff = 1;; ) {
+					if (!locked.load(std::memory_order_relaxed) && !locked.exchange(true, std::memory_order_acquire))
+						return;
+					if (backoff < maxBackoff) {
+						for (unsigned i = 0; i < backoff; ++i)
+							cpuRelax();
+						backoff *= 2;
+					}
+					else
+						std::this_thread::yield();
+				}
+			}
+			void unlock() noexcept {
+				locked.store(false, std::memory_order_release);
+			}
+		};
+	}
+
+	/**
+	 * A pointer like object that holds a guard (ie. a lock) while it is alive
+	 */
+	template<typename T, typename Guard>
+	class SingletonAccessProxy {
+	private:
+		Guard guard;
+		T* obj;
+	public:
+		template<typename ... Args>
+		explicit SingletonAccessProxy(T& obj, Args&& ... args) : guard(std::forward<Args>(args)...), obj(&obj) {}
+
+		SingletonAccessProxy(const SingletonAccessProxy&) = delete;
+		SingletonAccessProxy& operator=(const SingletonAccessProxy&) = delete;
+
+		T* operator->() const noexcept {
+			return obj;
+		}
+		T& operator*() const noexcept {
+			return *obj;
+		}
+	};
+
+	template<typename T>
+	struct DirectAccess {
+		static T& access(T& obj) noexcept {
+			return obj;
+		}
+	};
+
+	template<typename T>
+	struct MutexAccess {
+		static inline std::mutex mu;
+		static SingletonAccessProxy<T, std::lock_guard<std::mutex>> access(T& obj) {
+			return SingletonAccessProxy<T, std::lock_guard<std::mutex>>(obj, mu);
+		}
+	};
+
+	template<typename T>
+	struct SharedMutexAccess {
+		static inline std::shared_mutex mu;
+		static SingletonAccessProxy<T, std::unique_lock<std::shared_mutex>> access(T& obj) {
+			return SingletonAccessProxy<T, std::unique_lock<std::shared_mutex>>(obj, mu);
+		}
+		static SingletonAccessProxy<const T, std::shared_lock<std::shared_mutex>> read(T& obj) {
+			return SingletonAccessProxy<const T, std::shared_lock<std::shared_mutex>>(obj, mu);
+		}
+	};
+
+	template<typename T>
+	struct SpinLockAccess {
+		static inline SingletonAccessTracker::BackoffSpinLock lock;
+		static SingletonAccessProxy<T, std::lock_guard<SingletonAccessTracker::BackoffSpinLock>> access(T& obj) {
+			return SingletonAccessProxy<T, std::lock_guard<SingletonAccessTracker::BackoffSpinLock>>(obj, lock);
+		}
+	};
+
+	namespace SingletonAccessTracker {
+		/**
+		 * The widest unsigned type whose atomic_ref can be used on the object representation of T
+		 */
+		template<typename T>
+		using SeqWord = std::conditional_t<
+			alignof(T) % std::atomic_ref<std::uint64_t>::required_alignment == 0 && sizeof(T) % 8 == 0, std::uint64_t,
+			std::conditional_t<
+			alignof(T) % std::atomic_ref<std::uint32_t>::required_alignment == 0 && sizeof(T) % 4 == 0, std::uint32_t,
+			unsigned char>>;
+
+		template<typename T>
+		using SeqWords = std::array<SeqWord<T>, sizeof(T) / sizeof(SeqWord<T>)>;
+	}
+
+	/**
+	 * Writers are serialized by a spin lock, modify a copy of the object and publish it while the sequence is odd
+	 * Readers copy the object and retry if the sequence was odd or changed while they copied
+	 * Both copy the object word by word with relaxed atomics, so that a reader racing with a writer is not a data race
+	 */
+	template<typename T>
+	struct SeqLockAccess {
+		static_assert(std::is_trivially_copyable_v<T>, "SeqLockAccess requires a trivially copyable type");
+		using Words = SingletonAccessTracker::SeqWords<T>;
+		using Word = typename Words::value_type;
+
+		static inline std::atomic<unsigned> sequence{ 0 };
+		static inline SingletonAccessTracker::BackoffSpinLock writerLock;
+
+		/**
+		 * Holds the writer lock and a copy of the object, which is published when the proxy is destroyed
+		 */
+		class WriteProxy {
+		private:
+			T* obj;
+			T copy;
+		public:
+			explicit WriteProxy(T& obj) noexcept : obj(&obj), copy(lockAndLoad(obj)) {}
+			~WriteProxy() {
+				sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+				store(*obj, copy);
+				sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+				writerLock.unlock();
+			}
+			WriteProxy(const WriteProxy&) = delete;
+			WriteProxy& operator=(const WriteProxy&) = delete;
+
+			T* operator->() noexcept {
+				return &copy;
+			}
+			T& operator*() noexcept {
+				return copy;
+			}
+		};
+
+		static WriteProxy access(T& obj) noexcept {
+			return WriteProxy(obj);
+		}
+
+		/**
+		 * @return a copy of the object that was not written while it was copied
+		 */
+		static T read(T& obj) noexcept {
+			for (;;) {
+				const auto before = sequence.load(std::memory_order_acquire);
+				if (before & 1) {
+					SingletonAccessTracker::cpuRelax();
+					continue;
+				}
+				const T copy = load(obj);
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (sequence.load(std::memory_order_relaxed) == before)
+					return copy;
+			}
+		}
+	private:
+		static T lockAndLoad(T& obj) noexcept {
+			writerLock.lock();
+			return load(obj);
+		}
+		static T load(T& obj) noexcept {
+			Words words;
+			auto* source = reinterpret_cast<Word*>(&obj);
+			for (std::size_t i = 0; i < words.size(); ++i) {
+				words[i] = std::atomic_ref<Word>(source[i]).load(std::memory_order_relaxed);
+			}
+			return std::bit_cast<T>(words);
+		}
+		static void store(T& obj, const T& value) noexcept {
+			const auto words = std::bit_cast<Words>(value);
+			auto* target = reinterpret_cast<Word*>(&obj);
+			for (std::size_t i = 0; i < words.size(); ++i) {
+				std::atomic_ref<Word>(target[i]).store(words[i], std::memory_order_relaxed);
+			}
 		}
 	};
 
@@ -198,46 +619,206 @@ namespace SUtil {
 		static int lockSingleton() { return 0; };
 	};
 
+	template<typename T>
+	struct NoInstrumentation {
+		static constexpr bool enabled = false;
+	};
+
 	template<typename T,
 		SingletonDeadReferencePolicy deathPolicy = ErrorDeadRefPolicy,
 		template <typename> typename createPolicy = FreeStoreCreatePolicy,
 		SingletonDestructionPolicy destructionPolicy = StandardDestructionPolicy,
-		template<typename> typename coarseLockingPolicy = SingletonNoLock>
+		template<typename> typename coarseLockingPolicy = SingletonNoLock,
+		template<typename> typename accessPolicy = DirectAccess,
+		template<typename> typename instrumentationPolicy = NoInstrumentation>
 	requires SingletonCreatePolicy<createPolicy, T> &&
-		SingletonLockPolicy<coarseLockingPolicy<T>>
+		SingletonLockPolicy<coarseLockingPolicy<T>> &&
+		SingletonAccessPolicy<accessPolicy, T> &&
+		SingletonInstrumentationPolicy<instrumentationPolicy, T>
 	class Singleton {
 	public:
+		using object_type = T;
+		/// true if get() creates the object under the lock of the locking policy
+		static constexpr bool lockedCreation = !std::is_same_v<coarseLockingPolicy<T>, SingletonNoLock<T>>;
+
 		Singleton() {
-			isLive = true;
+			isLive.store(true, std::memory_order_relaxed);
 		}
 		~Singleton() {
-			isLive = false;
+			isLive.store(false, std::memory_order_relaxed);
 		}
 	private:
-		static inline T* instance = nullptr;
-		static inline bool isLive = false;
-	public:
-		static T& get() {
-			if (!instance) {
-				auto lk = coarseLockingPolicy<T>::lockSingleton();
-				initializeSingleton();
+		static constexpr bool constantInitialized = requires { createPolicy<T>::initialInstance(); };
+		static constexpr bool instrumented = instrumentationPolicy<T>::enabled;
+		using clock = std::chrono::steady_clock;
+
+		static constexpr T* initialInstance() noexcept {
+			if constexpr (constantInitialized)
+				return createPolicy<T>::initialInstance();
+			else
+				return nullptr;
+		}
+
+		/// published with release once fully constructed, null before creation and after destruction
+		static inline constinit std::atomic<T*> instance{ initialInstance() };
+		static inline constinit std::atomic<bool> isLive{ constantInitialized };
+
+		/**
+		 * Schedules the destruction of a constant initialized object during dynamic initialization,
+		 * since it is never created by get()
+		 */
+		struct InitialDestruction {
+			InitialDestruction() {
+				destructionPolicy::scheduleDestruction(&onDestroy);
 			}
-			return *instance;
+		};
+		static inline InitialDestruction initialDestruction;
+		static T& object() {
+			if constexpr (constantInitialized)
+				static_cast<void>(&initialDestruction);
+			if constexpr (instrumented)
+				instrumentationPolicy<T>::onGet();
+			// the acquire pairs with the release in createInstance(), it is a plain load on x86
+			if (auto* obj = instance.load(std::memory_order_acquire)) [[likely]]
+				return *obj;
+			return initializeSingleton();
+		}
+	public:
+		/**
+		 * @return the object, or a proxy to it depending on the access policy
+		 */
+		static decltype(auto) get() {
+			return accessPolicy<T>::access(object());
+		}
+
+		/**
+		 * Read only access, if the access policy distinguishes readers
+		 */
+		static decltype(auto) read() requires requires(T& obj) { accessPolicy<T>::read(obj); } {
+			return accessPolicy<T>::read(object());
+		}
+
+		/**
+		 * @return true if the object exists, without creating it
+		 */
+		static bool created() noexcept {
+			return instance.load(std::memory_order_acquire) != nullptr;
 		}
 	private:
 		static void onDestroy() noexcept {
-			isLive = false;
-			createPolicy<T>::free(instance);
+			isLive.store(false, std::memory_order_relaxed);
+			if constexpr (instrumented) {
+				const auto start = clock::now();
+				createPolicy<T>::free(instance.exchange(nullptr, std::memory_order_acq_rel));
+				instrumentationPolicy<T>::onDestroy(clock::now() - start);
+			}
+			else
+				createPolicy<T>::free(instance.exchange(nullptr, std::memory_order_acq_rel));
 		}
-		static void initializeSingleton() {
-			if (!instance) {
-				if (!isLive) {
-					deathPolicy::onDeadReference();
-				}
-				instance = createPolicy<T>::create();
-				destructionPolicy::scheduleDestruction(&onDestroy);
-				isLive = true;
+		/**
+		 * Called with the lock of the locking policy held
+		 */
+		static void createInstance() {
+			if (instance.load(std::memory_order_relaxed))
+				return;
+			if (!isLive.load(std::memory_order_relaxed)) {
+				deathPolicy::onDeadReference();
+			}
+			T* obj;
+			if constexpr (instrumented) {
+				const auto start = clock::now();
+				obj = createPolicy<T>::create();
+				instrumentationPolicy<T>::onCreate(clock::now() - start);
+			}
+			else
+				obj = createPolicy<T>::create();
+			destructionPolicy::scheduleDestruction(&onDestroy);
+			isLive.store(true, std::memory_order_relaxed);
+			instance.store(obj, std::memory_order_release);
+		}
+#if defined(__GNUC__) || defined(__clang__)
+		[[gnu::noinline, gnu::cold]]
+#endif
+		static T& initializeSingleton() {
+			if constexpr (requires { coarseLockingPolicy<T>::lockSingleton(); }) {
+				[[maybe_unused]] const auto start = instrumented ? clock::now() : clock::time_point();
+				[[maybe_unused]] auto lk = coarseLockingPolicy<T>::lockSingleton();
+				if constexpr (instrumented)
+					instrumentationPolicy<T>::onLock(clock::now() - start);
+				createInstance();
+			}
+			else
+				coarseLockingPolicy<T>::initializeOnce(&createInstance);
+			return *instance.load(std::memory_order_acquire);
+		}
+	};
+
+	/**
+	 * Creates the object of Single on a background thread
+	 * A Single::get() that happens while it is being created waits for it on the lock of the locking policy,
+	 * one that happens before the background thread takes the lock creates the object itself
+	 * If the object was destroyed, it is revived on the background thread through the dead reference policy
+	 * The background thread is joined by an atexit handler registered by the first getAsync(), so it does not
+	 * outlive main. Singletons scheduled for destruction before that are destroyed after it is joined
+	 * @param <Single> a Singleton whose locking policy is not SingletonNoLock
+	 */
+	template<typename Single>
+	requires Single::lockedCreation
+	class AsyncSingleton {
+	private:
+		/// the object with DirectAccess, nothing if get() returns a proxy
+		using result_type = std::conditional_t<std::is_lvalue_reference_v<decltype(Single::get())>,
+			decltype(Single::get()), void>;
+
+		static inline std::mutex lock;
+		static inline std::thread builder;
+		/// the last creation started by getAsync(), invalid if there was none
+		static inline std::shared_future<result_type> construction;
+		static inline bool joinScheduled = false;
+
+		static void join() noexcept {
+			std::lock_guard<std::mutex> lk(lock);
+			if (builder.joinable())
+				builder.join();
+		}
+		static result_type create() {
+			return static_cast<result_type>(Single::get());
+		}
+	public:
+		/**
+		 * Creates the object on a new thread if it does not exist and is not being created yet
+		 * @return a future of the object (or of its creation if get() returns a proxy),
+		 * holding the exception if creating it failed
+		 */
+		static std::shared_future<result_type> getAsync() {
+			std::lock_guard<std::mutex> lk(lock);
+			if (construction.valid() && construction.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				return construction;
+			if (Single::created()) {
+				std::promise<result_type> created;
+				if constexpr (std::is_void_v<result_type>)
+					created.set_value();
+				else
+					created.set_value(create());
+				return construction = created.get_future().share();
+			}
+			if (!joinScheduled) {
+				if (std::atexit(&join) != 0) throw std::bad_alloc();
+				joinScheduled = true;
 			}
+			if (builder.joinable())
+				builder.join();
+			std::packaged_task<result_type()> task(&create);
+			construction = task.get_future().share();
+			builder = std::thread(std::move(task));
+			return construction;
+		}
+
+		/**
+		 * Starts creating the object in the background, ie. early in main
+		 */
+		static void prefetch() {
+			static_cast<void>(getAsync());
 		}
 	};
 
@@ -256,6 +837,30 @@ namespace SUtil {
 		FreeStoreCreatePolicy, StandardDestructionPolicy,
 		SingletonLockGuard>;
 
+	/**
+	 * MTSingleton_t that creates the object with std::call_once
+	 */
+	template<typename T>
+	using OnceSingleton_t = Singleton<T, ErrorDeadRefPolicy,
+		FreeStoreCreatePolicy, StandardDestructionPolicy,
+		SingletonCallOnce>;
+
+	/**
+	 * MTSingleton_t whose object can only be used while holding its mutex
+	 */
+	template<typename T>
+	using LockedSingleton_t = Singleton<T, ErrorDeadRefPolicy,
+		FreeStoreCreatePolicy, StandardDestructionPolicy,
+		SingletonLockGuard, MutexAccess>;
+
+	/**
+	 * MTSingleton_t with a read() that can be used concurrently and a get() that is exclusive
+	 */
+	template<typename T>
+	using SharedLockedSingleton_t = Singleton<T, ErrorDeadRefPolicy,
+		FreeStoreCreatePolicy, StandardDestructionPolicy,
+		SingletonLockGuard, SharedMutexAccess>;
+
 	template<typename T, unsigned longevity>
 	using LifetimeSingleton_t = Singleton<T, ReviveDeadRefPolicy,
 		FreeStoreCreatePolicy, LongevityDestructionPolicy<longevity>,
@@ -0,0 +1,238 @@
+#pragma once
+#ifndef _SINGLETON_FAMILY_H
+#define _SINGLETON_FAMILY_H
+#include "Singleton.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+/**
+ * Singletons allocated together
+ * Usage:
+ *	- pick a tag type for the family, and create each member with SingletonFamily<Tag>::CreatePolicy
+ *		(ie. FamilySingleton_t<T, Tag, longevity>)
+ *	- the first member to be created reserves reservedBytes (rounded up to a huge page) for the whole family,
+ *		backed by huge pages when the system has them. Members are placed next to each other in it
+ *	- a revived member is reconstructed in the same place
+ *	- a member that does not fit is created on the free store instead
+ *	- the reservation is released in one step at exit, once the longevity tracker is done and every member
+ *		has been destroyed
+ *	- SingletonFamily<Tag>::usage() reports the memory of the family
+ */
+namespace SUtil {
+	/**
+	 * The memory of a family of singletons, in bytes
+	 */
+	struct SingletonFamilyUsage {
+		/// size of the reservation, 0 before the first member is created or if it could not be reserved
+		std::size_t reserved;
+		/// part of the reservation given to members, including alignment padding
+		std::size_t used;
+		/// taken by living members that did not fit in the reservation
+		std::size_t overflow;
+		/// members that are alive
+		std::size_t members;
+		/// true if the reservation is backed by explicit huge pages
+		bool hugePages;
+	};
+
+	/**
+	 * Not for external use
+	 */
+	namespace SingletonFamilyTracker {
+		constexpr inline std::size_t hugePageSize = 2 * 1024 * 1024;
+
+		struct Region {
+			std::byte* base = nullptr;
+			std::size_t size = 0;
+			bool hugePages = false;
+		};
+
+		/**
+		 * Maps size bytes (a multiple of hugePageSize) aligned to a huge page
+		 * @return an empty region if the memory could not be mapped
+		 */
+		inline Region mapRegion(std::size_t size) noexcept {
+#if defined(__linux__)
+#ifdef MAP_HUGETLB
+			if (void* huge = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+				-1, 0); huge != MAP_FAILED)
+				return { static_cast<std::byte*>(huge), size, true };
+#endif
+			// no huge pages are reserved, so map extra to align the region for transparent huge pages
+			void* mapped = mmap(nullptr, size + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (mapped == MAP_FAILED)
+				return {};
+			auto* start = static_cast<std::byte*>(mapped);
+			auto* aligned = reinterpret_cast<std::byte*>(
+				(reinterpret_cast<std::uintptr_t>(start) + hugePageSize - 1) / hugePageSize * hugePageSize);
+			if (aligned != start)
+				munmap(start, static_cast<std::size_t>(aligned - start));
+			if (auto tail = static_cast<std::size_t>(start + hugePageSize - aligned); tail != 0)
+				munmap(aligned + size, tail);
+#ifdef MADV_HUGEPAGE
+			madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+			return { aligned, size, false };
+#else
+			auto* memory = ::operator new(size, std::align_val_t(hugePageSize), std::nothrow);
+			if (memory == nullptr)
+				return {};
+			return { static_cast<std::byte*>(memory), size, false };
+#endif
+		}
+
+		inline void unmapRegion(const Region& region) noexcept {
+			if (region.base == nullptr)
+				return;
+#if defined(__linux__)
+			munmap(region.base, region.size);
+#else
+			::operator delete(region.base, std::align_val_t(hugePageSize));
+#endif
+		}
+	}
+
+	/**
+	 * @param <Family> tag type of the family
+	 * @param <reservedBytes> memory reserved for all members
+	 */
+	template<typename Family, std::size_t reservedBytes = SingletonFamilyTracker::hugePageSize>
+	class SingletonFamily {
+	private:
+		using Region = SingletonFamilyTracker::Region;
+		static constexpr std::size_t reservation = (reservedBytes + SingletonFamilyTracker::hugePageSize - 1) /
+			SingletonFamilyTracker::hugePageSize * SingletonFamilyTracker::hugePageSize;
+
+		/// constant initialized, so that members can be created during the initialization of other globals
+		struct State {
+			std::mutex lock;
+			Region region;
+			std::size_t used = 0;
+			std::size_t overflow = 0;
+			std::size_t members = 0;
+			/// incremented when the reservation is released, so that members don't reuse their old place
+			unsigned generation = 0;
+			/// true until the first member reserves the memory
+			bool reserving = true;
+			/// the longevity tracker is done, so the reservation is released with the last member
+			bool exiting = false;
+		};
+		static inline constinit State state;
+
+		/**
+		 * Requires the lock to be held
+		 * @return memory in the reservation, or null if it does not fit
+		 */
+		static void* allocate(std::size_t size, std::size_t alignment) {
+			if (state.region.base == nullptr)
+				return nullptr;
+			void* ptr = state.region.base + state.used;
+			auto space = state.region.size - state.used;
+			if (!std::align(alignment, size, ptr, space))
+				return nullptr;
+			state.used = static_cast<std::size_t>(static_cast<std::byte*>(ptr) + size - state.region.base);
+			return ptr;
+		}
+
+		/**
+		 * Requires the lock to be held
+		 */
+		static void unmap() noexcept {
+			SingletonFamilyTracker::unmapRegion(state.region);
+			state.region = {};
+			state.used = 0;
+			++state.generation;
+		}
+
+		/**
+		 * Runs after every singleton in the longevity tracker
+		 */
+		static void release() noexcept {
+			std::lock_guard<std::mutex> lk(state.lock);
+			state.exiting = true;
+			if (state.members == 0)
+				unmap();
+		}
+	public:
+		template<typename T>
+		struct CreatePolicy {
+		private:
+			/// the place of T in the reservation, valid while slotGeneration is the generation of the family
+			static inline T* slot = nullptr;
+			static inline unsigned slotGeneration = 0;
+		public:
+			static T* create() {
+				void* storage;
+				bool reserved = false;
+				{
+					std::lock_guard<std::mutex> lk(state.lock);
+					if (state.reserving) {
+						state.reserving = false;
+						state.region = SingletonFamilyTracker::mapRegion(reservation);
+						reserved = state.region.base != nullptr;
+					}
+					if (slot == nullptr || slotGeneration != state.generation) {
+						slot = static_cast<T*>(allocate(sizeof(T), SingletonStorageTracker::storageAlignment<T>));
+						slotGeneration = state.generation;
+					}
+					storage = slot;
+					++state.members;
+					if (storage == nullptr)
+						state.overflow += sizeof(T);
+				}
+				// without the lock, since release() is called right away if it cannot be scheduled
+				if (reserved)
+					SingletonLongevityTracker::scheduleLast(&release);
+				try {
+					if (storage)
+						return ::new (storage) T();
+					return new T();
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> lk(state.lock);
+					--state.members;
+					if (storage == nullptr)
+						state.overflow -= sizeof(T);
+					throw;
+				}
+			}
+			static void free(T* instance) noexcept {
+				if (instance == nullptr)
+					return;
+				bool inReservation;
+				{
+					std::lock_guard<std::mutex> lk(state.lock);
+					inReservation = instance == slot && slotGeneration == state.generation;
+				}
+				if (inReservation)
+					instance->~T();
+				else
+					delete instance;
+				std::lock_guard<std::mutex> lk(state.lock);
+				if (!inReservation)
+					state.overflow -= sizeof(T);
+				if (--state.members == 0 && state.exiting)
+					unmap();
+			}
+		};
+
+		static SingletonFamilyUsage usage() {
+			std::lock_guard<std::mutex> lk(state.lock);
+			return { state.region.size, state.used, state.overflow, state.members, state.region.hugePages };
+		}
+	};
+
+	/**
+	 * A thread safe singleton allocated with the other singletons of Family, and destroyed in longevity order
+	 */
+	template<typename T, typename Family, unsigned longevity>
+	using FamilySingleton_t = Singleton<T, ReviveDeadRefPolicy,
+		SingletonFamily<Family>::template CreatePolicy, LongevityDestructionPolicy<longevity>,
+		SingletonLockGuard>;
+}
+#endif
@@ -0,0 +1,346 @@
+#pragma once
+#ifndef _SINGLETON_REGISTRY_H
+#define _SINGLETON_REGISTRY_H
+#include "Singleton.hpp"
+#include "TypeId.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+/**
+ * Singletons that declare which other singletons they depend on
+ * Usage:
+ *	- declare a global SingletonRegistration<Single, Dependencies...> for each singleton, where Single and
+ *		Dependencies are Singleton types
+ *	- warmUpSingletons(executor) creates every registered singleton, a singleton is created once all of its
+ *		dependencies have been, independent singletons are created concurrently
+ *	- singletons with a DependencyDestructionPolicy (ie. DependentSingleton_t) are destroyed after every singleton that
+ *		depends on them, without assigning longevities by hand
+ * Registrations are globals, so they must not be relied on during the initialization of other globals
+ */
+namespace SUtil {
+	class SingletonDependencyException : public std::exception {
+	public:
+		const char* what() const noexcept override {
+			return "Singleton dependencies form a cycle";
+		}
+	};
+
+	/**
+	 * The time get() took for a singleton during warmUpSingletons
+	 */
+	struct SingletonConstructionTime {
+		TypeId type;
+		std::chrono::nanoseconds time;
+	};
+
+	/**
+	 * Not for external use
+	 */
+	namespace SingletonRegistryTracker {
+		struct Node {
+			TypeId type;
+			/// calls get() of the singleton, null if the type was never registered
+			void(*create)() = nullptr;
+			Node* const* dependencies = nullptr;
+			std::size_t dependencyCount = 0;
+			Node* nextRegistered = nullptr;
+			/// length of the longest chain of dependencies below this node, -1 if not computed yet
+			int depth = -1;
+			bool visiting = false;
+		};
+
+		/// the node of a type is constant initialized, so dependencies can point to it before it is registered
+		template<typename T>
+		inline constinit Node node{ typeId<T>() };
+
+		inline constinit Node* registered = nullptr;
+		inline std::mutex registryLock;
+
+		template<typename Single>
+		using object_t = typename Single::object_type;
+
+		/**
+		 * Requires registryLock to be held
+		 */
+		inline int depthOf(Node& node) {
+			if (node.depth >= 0)
+				return node.depth;
+			if (node.visiting)
+				throw SingletonDependencyException();
+			node.visiting = true;
+			int depth = 0;
+			try {
+				for (std::size_t i = 0; i < node.dependencyCount; ++i) {
+					depth = std::max(depth, depthOf(*node.dependencies[i]) + 1);
+				}
+			}
+			catch (...) {
+				node.visiting = false;
+				throw;
+			}
+			node.visiting = false;
+			node.depth = depth;
+			return depth;
+		}
+
+		/**
+		 * The registered singletons and their dependencies, with the edges reversed
+		 */
+		struct Graph {
+			std::vector<Node*> nodes;
+			std::vector<std::vector<std::size_t>> dependents;
+			std::vector<std::size_t> dependencyCounts;
+
+			/**
+			 * Requires registryLock to be held
+			 * @throw SingletonDependencyException if there is a cycle
+			 */
+			Graph() {
+				std::unordered_map<Node*, std::size_t> index;
+				const auto add = [&](Node* node) {
+					auto [it, added] = index.try_emplace(node, nodes.size());
+					if (added) {
+						nodes.push_back(node);
+						dependents.emplace_back();
+						dependencyCounts.push_back(0);
+					}
+					return it->second;
+				};
+				for (auto* node = registered; node; node = node->nextRegistered) {
+					add(node);
+				}
+				// nodes grows while it is walked, adding dependencies that were never registered themselves
+				for (std::size_t i = 0; i < nodes.size(); ++i) {
+					for (std::size_t d = 0; d < nodes[i]->dependencyCount; ++d) {
+						const auto dependency = add(nodes[i]->dependencies[d]);
+						dependents[dependency].push_back(i);
+						++dependencyCounts[i];
+					}
+				}
+				for (auto* node : nodes) {
+					depthOf(*node);
+				}
+			}
+		};
+
+		/**
+		 * Progress of a warm up, shared by the jobs given to the executor
+		 */
+		template<typename Executor>
+		struct WarmUp {
+			Graph& graph;
+			Executor& executor;
+			std::vector<std::atomic<std::size_t>> waiting;
+			std::vector<SingletonConstructionTime> times;
+			std::mutex lock;
+			std::condition_variable finished;
+			std::size_t remaining;
+			std::exception_ptr error;
+			std::atomic<bool> failed{ false };
+
+			WarmUp(Graph& graph, Executor& executor) : graph(graph), executor(executor),
+				waiting(graph.nodes.size()), remaining(graph.nodes.size()) {
+				for (std::size_t i = 0; i < graph.nodes.size(); ++i) {
+					waiting[i].store(graph.dependencyCounts[i], std::memory_order_relaxed);
+				}
+			}
+
+			void submit(std::size_t node) {
+				executor(std::function<void()>([this, node]() { create(node); }));
+			}
+
+			/**
+			 * Once a singleton failed, the rest are not created but still finish so that the warm up ends
+			 */
+			void create(std::size_t node) {
+				auto* create = graph.nodes[node]->create;
+				if (create && !failed.load(std::memory_order_relaxed)) {
+					try {
+						const auto start = std::chrono::steady_clock::now();
+						create();
+						const auto end = std::chrono::steady_clock::now();
+						std::lock_guard<std::mutex> lk(lock);
+						times.push_back({ graph.nodes[node]->type,
+							std::chrono::duration_cast<std::chrono::nanoseconds>(end - start) });
+					}
+					catch (...) {
+						std::lock_guard<std::mutex> lk(lock);
+						if (!error)
+							error = std::current_exception();
+						failed.store(true, std::memory_order_relaxed);
+					}
+				}
+				for (auto dependent : graph.dependents[node]) {
+					if (waiting[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+						submit(dependent);
+				}
+				std::lock_guard<std::mutex> lk(lock);
+				if (--remaining == 0)
+					finished.notify_all();
+			}
+		};
+
+		/**
+		 * Runs jobs on a fixed amount of threads until it is destroyed
+		 */
+		class ThreadPool {
+		private:
+			std::mutex lock;
+			std::condition_variable wake;
+			std::deque<std::function<void()>> jobs;
+			bool stopping = false;
+			std::vector<std::jthread> workers;
+
+			void work() {
+				for (;;) {
+					std::function<void()> job;
+					{
+						std::unique_lock<std::mutex> lk(lock);
+						wake.wait(lk, [this]() { return stopping || !jobs.empty(); });
+						if (jobs.empty())
+							return;
+						job = std::move(jobs.front());
+						jobs.pop_front();
+					}
+					job();
+				}
+			}
+		public:
+			explicit ThreadPool(unsigned threads) {
+				workers.reserve(threads);
+				for (unsigned i = 0; i < threads; ++i) {
+					workers.emplace_back([this]() { work(); });
+				}
+			}
+
+			~ThreadPool() {
+				{
+					std::lock_guard<std::mutex> lk(lock);
+					stopping = true;
+				}
+				wake.notify_all();
+			}
+
+			void operator()(std::function<void()> job) {
+				{
+					std::lock_guard<std::mutex> lk(lock);
+					jobs.push_back(std::move(job));
+				}
+				wake.notify_one();
+			}
+		};
+	}
+
+	/**
+	 * Singletons with this policy are destroyed after all registered singletons that depend on them
+	 * They are scheduled with the LongevityDestructionPolicy, with longevities above any practical hand assigned one
+	 * @param <T> the type of the object in the singleton
+	 */
+	template<typename T>
+	struct DependencyDestructionPolicy {
+		static void scheduleDestruction(void(*destroyer)(void)) {
+			int depth;
+			{
+				std::lock_guard<std::mutex> lk(SingletonRegistryTracker::registryLock);
+				depth = SingletonRegistryTracker::depthOf(SingletonRegistryTracker::node<T>);
+			}
+			SingletonLongevityTracker::scheduleDestruction({ destroyer,
+				std::numeric_limits<unsigned>::max() - static_cast<unsigned>(depth), 0 });
+		}
+	};
+
+	/**
+	 * A thread safe singleton destroyed in reverse dependency order, to be registered with a SingletonRegistration
+	 */
+	template<typename T>
+	using DependentSingleton_t = Singleton<T, ReviveDeadRefPolicy,
+		FreeStoreCreatePolicy, DependencyDestructionPolicy<T>,
+		SingletonLockGuard>;
+
+	/**
+	 * Declares a singleton and the singletons it depends on, define one as a global for each singleton
+	 * @param <Single> a Singleton type
+	 * @param <Dependencies> the Singleton types that Single uses
+	 */
+	template<typename Single, typename ... Dependencies>
+	class SingletonRegistration {
+	private:
+		static constexpr SingletonRegistryTracker::Node* dependencies[] = {
+			&SingletonRegistryTracker::node<SingletonRegistryTracker::object_t<Dependencies>>..., nullptr };
+
+		static void create() {
+			Single::get();
+		}
+	public:
+		SingletonRegistration() {
+			auto& node = SingletonRegistryTracker::node<SingletonRegistryTracker::object_t<Single>>;
+			std::lock_guard<std::mutex> lk(SingletonRegistryTracker::registryLock);
+			if (node.create)
+				return;
+			node.create = &create;
+			node.dependencies = dependencies;
+			node.dependencyCount = sizeof...(Dependencies);
+			node.nextRegistered = std::exchange(SingletonRegistryTracker::registered, &node);
+			// a depth computed while this type had no known dependencies is stale
+			for (auto* n = SingletonRegistryTracker::registered; n; n = n->nextRegistered) {
+				n->depth = -1;
+				for (std::size_t i = 0; i < n->dependencyCount; ++i) {
+					n->dependencies[i]->depth = -1;
+				}
+			}
+		}
+	};
+
+	/**
+	 * Creates every registered singleton, each after the singletons it depends on
+	 * If creating a singleton throws, no more are created and the first exception is rethrown
+	 * @param executor callable with a std::function<void()>, that runs the function on any thread
+	 * @return the construction time of each singleton, slowest first
+	 * @throw SingletonDependencyException if the dependencies form a cycle
+	 */
+	template<typename Executor>
+		requires std::invocable<Executor&, std::function<void()>>
+	std::vector<SingletonConstructionTime> warmUpSingletons(Executor&& executor) {
+		std::unique_lock<std::mutex> registryLock(SingletonRegistryTracker::registryLock);
+		SingletonRegistryTracker::Graph graph;
+		registryLock.unlock();
+		SingletonRegistryTracker::WarmUp<std::remove_reference_t<Executor>> warmUp(graph, executor);
+		if (!graph.nodes.empty()) {
+			for (std::size_t i = 0; i < graph.nodes.size(); ++i) {
+				if (graph.dependencyCounts[i] == 0)
+					warmUp.submit(i);
+			}
+			std::unique_lock<std::mutex> lk(warmUp.lock);
+			warmUp.finished.wait(lk, [&warmUp]() { return warmUp.remaining == 0; });
+		}
+		if (warmUp.error)
+			std::rethrow_exception(warmUp.error);
+		std::sort(warmUp.times.begin(), warmUp.times.end(), [](const auto& a, const auto& b) {
+			return a.time > b.time;
+		});
+		return std::move(warmUp.times);
+	}
+
+	/**
+	 * Creates every registered singleton on a pool of threads
+	 */
+	inline std::vector<SingletonConstructionTime> warmUpSingletons(
+		unsigned threads = std::max(1u, std::thread::hardware_concurrency())) {
+		SingletonRegistryTracker::ThreadPool pool(threads);
+		return warmUpSingletons(pool);
+	}
+}
+#endif
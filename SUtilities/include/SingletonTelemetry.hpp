@@ -0,0 +1,279 @@
+#pragma once
+#ifndef _SINGLETON_TELEMETRY_H
+#define _SINGLETON_TELEMETRY_H
+#include "Singleton.hpp"
+#include "TypeId.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+/**
+ * Lifecycle telemetry of singletons
+ * Usage:
+ *	- give a Singleton the SingletonTelemetry instrumentation policy (ie. TimedSingleton_t)
+ *	- call markSingletonSteadyState() at the start of main. get() calls before it count as start-up calls
+ *	- singletonTelemetry() returns what was recorded for every instrumented singleton
+ *	- the report is printed to stderr at exit, disable it with setSingletonTelemetryReport(false)
+ * Recorded per singleton: the time creating and destroying the object took, the thread that created it,
+ * the time spent waiting for the lock of a locking policy with lockSingleton() and the amount of get() calls
+ * The report is scheduled with the LongevityDestructionPolicy after every other singleton with one, so that their
+ * destruction times are known. Singletons destroyed after the report (ie. by StandardDestructionPolicy) are not in it
+ */
+namespace SUtil {
+	/**
+	 * What was recorded for an instrumented singleton, times are the sum over every time it was created
+	 */
+	struct SingletonLifecycle {
+		std::string_view type;
+		/// the thread that created the object last
+		std::thread::id creator;
+		std::chrono::nanoseconds construction;
+		std::chrono::nanoseconds lockWait;
+		std::chrono::nanoseconds destruction;
+		std::uint64_t creations;
+		std::uint64_t destructions;
+		std::uint64_t startupGets;
+		std::uint64_t steadyGets;
+
+		/**
+		 * @return the start-up and shutdown latency the singleton caused
+		 */
+		std::chrono::nanoseconds total() const noexcept {
+			return construction + lockWait + destruction;
+		}
+	};
+
+	/**
+	 * Not for external use
+	 */
+	namespace SingletonTelemetryTracker {
+		inline constinit std::atomic<bool> steadyState{ false };
+		inline constinit std::atomic<bool> reportAtExit{ true };
+		inline constinit std::mutex lock;
+
+		struct Record;
+		inline constinit Record* records = nullptr;
+
+		inline void report() noexcept;
+
+		struct ThreadGets;
+		/// the get() counters of every living thread, guarded by lock
+		inline constinit ThreadGets* threadGets = nullptr;
+
+		/**
+		 * A record exists once its singleton is first used, and is never destroyed
+		 */
+		struct Record {
+			TypeId type;
+			/// the rest is guarded by lock
+			/// get() calls of the threads that have exited
+			std::uint64_t startupGets = 0;
+			std::uint64_t steadyGets = 0;
+			std::thread::id creator;
+			std::chrono::nanoseconds construction{ 0 };
+			std::chrono::nanoseconds lockWait{ 0 };
+			std::chrono::nanoseconds destruction{ 0 };
+			std::uint64_t creations = 0;
+			std::uint64_t destructions = 0;
+			Record* next = nullptr;
+
+			explicit Record(TypeId type) : type(type) {
+				bool first;
+				{
+					std::lock_guard<std::mutex> lk(lock);
+					first = records == nullptr;
+					next = std::exchange(records, this);
+				}
+				if (first)
+					SingletonLongevityTracker::scheduleLast(&report);
+			}
+
+			/**
+			 * Requires the lock to be held
+			 */
+			inline SingletonLifecycle lifecycle() const;
+		};
+
+		template<typename T>
+		Record& recordOf() {
+			// trivially destructible, so it can still be used while the program exits
+			static Record record(typeId<T>());
+			return record;
+		}
+
+		/**
+		 * The get() calls of one thread for one singleton
+		 * Written by the owning thread only, so that get() does not write a cache line shared between threads
+		 */
+		struct ThreadGets {
+			Record& record;
+			std::atomic<std::uint64_t> startup{ 0 };
+			std::atomic<std::uint64_t> steady{ 0 };
+			ThreadGets* prev = nullptr;
+			ThreadGets* next = nullptr;
+
+			explicit ThreadGets(Record& record) : record(record) {
+				std::lock_guard<std::mutex> lk(lock);
+				next = std::exchange(threadGets, this);
+				if (next)
+					next->prev = this;
+			}
+			~ThreadGets() {
+				std::lock_guard<std::mutex> lk(lock);
+				record.startupGets += startup.load(std::memory_order_relaxed);
+				record.steadyGets += steady.load(std::memory_order_relaxed);
+				(prev ? prev->next : threadGets) = next;
+				if (next)
+					next->prev = prev;
+			}
+			ThreadGets(const ThreadGets&) = delete;
+			ThreadGets& operator=(const ThreadGets&) = delete;
+
+			/// single writer, so a load and a store is enough
+			static void bump(std::atomic<std::uint64_t>& counter) noexcept {
+				counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			}
+		};
+
+		template<typename T>
+		ThreadGets& threadGetsOf() {
+			thread_local ThreadGets gets(recordOf<T>());
+			return gets;
+		}
+
+		SingletonLifecycle Record::lifecycle() const {
+			auto startup = startupGets;
+			auto steady = steadyGets;
+			for (auto* gets = threadGets; gets; gets = gets->next) {
+				if (&gets->record == this) {
+					startup += gets->startup.load(std::memory_order_relaxed);
+					steady += gets->steady.load(std::memory_order_relaxed);
+				}
+			}
+			return { type.name(), creator, construction, lockWait, destruction, creations, destructions,
+				startup, steady };
+		}
+
+		inline std::vector<SingletonLifecycle> lifecycles() {
+			std::vector<SingletonLifecycle> result;
+			std::lock_guard<std::mutex> lk(lock);
+			for (auto* record = records; record; record = record->next) {
+				result.push_back(record->lifecycle());
+			}
+			std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+				return a.total() > b.total();
+			});
+			return result;
+		}
+	}
+
+	/**
+	 * Records the lifecycle of the singleton of T
+	 * get() counts its calls in counters of its own thread, which are merged when the telemetry is read
+	 */
+	template<typename T>
+	struct SingletonTelemetry {
+		static constexpr bool enabled = true;
+
+		static void onGet() {
+			using SingletonTelemetryTracker::ThreadGets;
+			auto& gets = SingletonTelemetryTracker::threadGetsOf<T>();
+			ThreadGets::bump(SingletonTelemetryTracker::steadyState.load(std::memory_order_relaxed) ?
+				gets.steady : gets.startup);
+		}
+		static void onLock(std::chrono::nanoseconds waited) {
+			auto& record = SingletonTelemetryTracker::recordOf<T>();
+			std::lock_guard<std::mutex> lk(SingletonTelemetryTracker::lock);
+			record.lockWait += waited;
+		}
+		static void onCreate(std::chrono::nanoseconds time) {
+			auto& record = SingletonTelemetryTracker::recordOf<T>();
+			std::lock_guard<std::mutex> lk(SingletonTelemetryTracker::lock);
+			record.construction += time;
+			record.creator = std::this_thread::get_id();
+			++record.creations;
+		}
+		static void onDestroy(std::chrono::nanoseconds time) noexcept {
+			auto& record = SingletonTelemetryTracker::recordOf<T>();
+			std::lock_guard<std::mutex> lk(SingletonTelemetryTracker::lock);
+			record.destruction += time;
+			++record.destructions;
+		}
+	};
+
+	/**
+	 * A thread safe singleton that records its lifecycle
+	 */
+	template<typename T>
+	using TimedSingleton_t = Singleton<T, ErrorDeadRefPolicy,
+		FreeStoreCreatePolicy, StandardDestructionPolicy,
+		SingletonLockGuard, DirectAccess, SingletonTelemetry>;
+
+	/**
+	 * Ends start-up, later get() calls are counted as steady state calls
+	 */
+	inline void markSingletonSteadyState() noexcept {
+		SingletonTelemetryTracker::steadyState.store(true, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @return what was recorded for each instrumented singleton that was used, the most expensive first
+	 */
+	inline std::vector<SingletonLifecycle> singletonTelemetry() {
+		return SingletonTelemetryTracker::lifecycles();
+	}
+
+	/**
+	 * Enables or disables the report printed at exit
+	 */
+	inline void setSingletonTelemetryReport(bool enabled) noexcept {
+		SingletonTelemetryTracker::reportAtExit.store(enabled, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Prints one line per singleton, the most expensive first
+	 */
+	inline void printSingletonTelemetry(std::ostream& out, const std::vector<SingletonLifecycle>& lifecycles) {
+		out << std::setw(12) << "create ms" << std::setw(12) << "lock ms" << std::setw(12) << "destroy ms"
+			<< std::setw(12) << "start gets" << std::setw(14) << "steady gets" << std::setw(20) << "creator"
+			<< "  singleton\n";
+		const auto millis = [](std::chrono::nanoseconds time) {
+			return std::chrono::duration<double, std::milli>(time).count();
+		};
+		for (const auto& single : lifecycles) {
+			out << std::fixed << std::setprecision(3) << std::setw(12) << millis(single.construction)
+				<< std::setw(12) << millis(single.lockWait) << std::setw(12) << millis(single.destruction)
+				<< std::setw(12) << single.startupGets << std::setw(14) << single.steadyGets
+				<< std::setw(20) << single.creator << "  " << single.type << '\n';
+		}
+		out << std::defaultfloat;
+	}
+
+	inline void printSingletonTelemetry(std::ostream& out) {
+		printSingletonTelemetry(out, singletonTelemetry());
+	}
+
+	/**
+	 * Runs after every singleton in the longevity tracker
+	 */
+	void SingletonTelemetryTracker::report() noexcept {
+		if (!reportAtExit.load(std::memory_order_relaxed))
+			return;
+		try {
+			std::cerr << "Singleton telemetry\n";
+			printSingletonTelemetry(std::cerr);
+		}
+		catch (...) {
+			// nothing can be done about a failed report at exit
+		}
+	}
+}
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef _STATIC_VISITABLE_H
+#define _STATIC_VISITABLE_H
+#include "Visitable.hpp"
+#include <concepts>
+/**
+ * Statically dispatched visitables
+ * When the static types of both the visitable and the visitor are known, accept() calls visit()
+ * directly so the compiler can inline the whole visit
+ * Usage:
+ *	- make the (preferably final) class inherit from StaticVisitable<Self>
+ *	- to also be visitable through a BaseVisitable, inherit from both and use MAKE_STATIC_VISITABLE(ReturnType)
+ *		instead of MAKE_VISITABLE. accept(visitor) is statically dispatched if the visitor visits exactly the class,
+ *		and goes through the BaseVisitable otherwise, so both dispatches call the same visit function
+ *	- any type with a visit(Self&) or visit(const Self&) function is a StaticVisitor, including subtypes of Visitor<>
+ *		Mark them final so that their visit functions can be inlined as well
+ *	- a visit(Parent&) does not make a StaticVisitor of Self, as the dynamic dispatch wouldn't find it either
+ */
+namespace SUtil {
+	/**
+	 * Not for external use
+	 */
+	namespace StaticVisitableTracker {
+		/**
+		 * Only binds to a T& (or a const T&), so that a visit function of a base of T or of a conversion isn't found
+		 */
+		template<typename T>
+		struct Exactly {
+			template<typename U>
+				requires std::same_as<U, T>
+			operator U&() const;
+		};
+	}
+
+	/**
+	 * A visitor with a visit function that takes exactly a T&
+	 */
+	template<typename V, typename T>
+	concept StaticVisitor = requires(V& visitor, StaticVisitableTracker::Exactly<T> visited) {
+		visitor.visit(visited);
+	};
+
+	/**
+	 * @param <Derived> the class inheriting from this one
+	 */
+	template<typename Derived>
+	class StaticVisitable {
+	public:
+		template<typename V>
+			requires StaticVisitor<V, Derived>
+		decltype(auto) accept(V& visitor) {
+			return visitor.visit(static_cast<Derived&>(*this));
+		}
+
+		template<typename V>
+			requires StaticVisitor<V, const Derived>
+		decltype(auto) accept(V& visitor) const {
+			return visitor.visit(static_cast<const Derived&>(*this));
+		}
+	protected:
+		~StaticVisitable() = default;
+	};
+}
+/**
+ * MAKE_VISITABLE for classes that inherit from a BaseVisitable and StaticVisitable
+ */
+#define MAKE_STATIC_VISITABLE(ReturnType) \
+	MAKE_VISITABLE(ReturnType) \
+	using StaticVisitable::accept
+#endif
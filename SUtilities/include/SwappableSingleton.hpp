@@ -0,0 +1,276 @@
+#pragma once
+#ifndef _SWAPPABLE_SINGLETON_H
+#define _SWAPPABLE_SINGLETON_H
+#include "Singleton.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+/**
+ * A singleton whose object can be replaced while it is read, ie. a configuration that is reloaded at runtime
+ * Usage:
+ *	- auto snapshot = SwappableSingleton<T>::get() gives read access to the current version until snapshot is destroyed
+ *	- publish(std::make_unique<T>(...)) replaces the current version, readers that already have a snapshot keep
+ *		reading the old version
+ *	- old versions are deleted once no snapshot can refer to them (epoch based reclamation), either by a later publish
+ *		or by synchronize()
+ *	- the destruction of the singleton deletes the versions that are not read, the rest are leaked at exit
+ * Readers never block, taking a snapshot is one store and two loads. Versions are immutable once published
+ * The first get() creates a default constructed T if nothing was published yet
+ */
+namespace SUtil {
+	/**
+	 * Not for external use
+	 */
+	namespace SwappableSingletonTracker {
+		/**
+		 * The state of one reading thread, padded so that readers do not share cache lines
+		 */
+		struct alignas(SingletonStorageTracker::cacheLine) Reader {
+			/// epoch in which the outermost snapshot of the thread was taken, 0 when there is none
+			std::atomic<std::uint64_t> epoch{ 0 };
+			std::atomic<bool> inUse{ true };
+			/// only used by the owning thread
+			unsigned nesting = 0;
+			Reader* next = nullptr;
+		};
+
+		/**
+		 * Gives the reader of an exited thread to the next new thread
+		 */
+		struct ReaderHolder {
+			Reader* reader = nullptr;
+			~ReaderHolder() {
+				if (reader)
+					reader->inUse.store(false, std::memory_order_release);
+			}
+		};
+	}
+
+	template<typename T,
+		SingletonDeadReferencePolicy deathPolicy = ErrorDeadRefPolicy,
+		SingletonDestructionPolicy destructionPolicy = StandardDestructionPolicy>
+	class SwappableSingleton {
+	private:
+		using Reader = SwappableSingletonTracker::Reader;
+
+		struct Retired {
+			/// the epoch the version was replaced in, readers of later epochs cannot see it
+			std::uint64_t epoch;
+			T* version;
+		};
+
+		static inline std::atomic<T*> current{ nullptr };
+		static inline std::atomic<std::uint64_t> epoch{ 1 };
+		/// readers are never freed, the readers of exited threads are reused
+		static inline std::atomic<Reader*> readers{ nullptr };
+		static inline thread_local SwappableSingletonTracker::ReaderHolder localReader;
+
+		/// guards the fields below, only taken by writers
+		static inline std::mutex writerLock;
+		static inline std::vector<Retired> retired;
+		static inline bool scheduled = false;
+		static inline std::atomic<bool> isLive{ false };
+
+#if defined(__GNUC__) || defined(__clang__)
+		[[gnu::noinline, gnu::cold]]
+#endif
+		static Reader* acquireReader() {
+			for (auto* reader = readers.load(std::memory_order_acquire); reader; reader = reader->next) {
+				if (!reader->inUse.load(std::memory_order_relaxed) &&
+					!reader->inUse.exchange(true, std::memory_order_acquire))
+					return localReader.reader = reader;
+			}
+			auto* reader = new Reader();
+			reader->next = readers.load(std::memory_order_relaxed);
+			while (!readers.compare_exchange_weak(reader->next, reader, std::memory_order_release,
+				std::memory_order_relaxed)) {}
+			return localReader.reader = reader;
+		}
+
+		static Reader& threadReader() {
+			auto* reader = localReader.reader;
+			if (!reader) [[unlikely]]
+				reader = acquireReader();
+			return *reader;
+		}
+
+		/**
+		 * @return the oldest epoch a snapshot is being read in, or the maximum epoch if there is none
+		 */
+		static std::uint64_t oldestReadEpoch() noexcept {
+			auto oldest = std::numeric_limits<std::uint64_t>::max();
+			for (auto* reader = readers.load(std::memory_order_acquire); reader; reader = reader->next) {
+				if (const auto e = reader->epoch.load(std::memory_order_seq_cst); e != 0)
+					oldest = std::min(oldest, e);
+			}
+			return oldest;
+		}
+
+		/**
+		 * Deletes the versions no snapshot can refer to, requires writerLock to be held
+		 */
+		static void reclaim() noexcept {
+			const auto oldest = oldestReadEpoch();
+			const auto kept = std::partition(retired.begin(), retired.end(), [oldest](const Retired& r) {
+				return r.epoch >= oldest;
+			});
+			std::for_each(kept, retired.end(), [](const Retired& r) { delete r.version; });
+			retired.erase(kept, retired.end());
+		}
+
+		/**
+		 * Requires writerLock to be held
+		 */
+		static void retire(T* version) {
+			if (!version)
+				return;
+			// reserve first so that a version is never lost
+			retired.reserve(retired.size() + 1);
+			retired.push_back({ epoch.fetch_add(1, std::memory_order_seq_cst), version });
+		}
+
+		/**
+		 * Requires writerLock to be held, called before a version is installed
+		 */
+		static void onCreate() {
+			if (!isLive.load(std::memory_order_relaxed) && !current.load(std::memory_order_relaxed)) {
+				deathPolicy::onDeadReference();
+			}
+			if (!scheduled) {
+				destructionPolicy::scheduleDestruction(&onDestroy);
+				scheduled = true;
+			}
+			isLive.store(true, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Does not wait for readers, a thread that never releases its snapshot (ie. a detached thread) would
+		 * hang the exit. Versions that are still read stay retired, and are leaked if nothing reclaims them later
+		 */
+		static void onDestroy() noexcept {
+			std::lock_guard<std::mutex> lk(writerLock);
+			isLive.store(false, std::memory_order_relaxed);
+			scheduled = false;
+			try {
+				retire(current.exchange(nullptr, std::memory_order_seq_cst));
+			}
+			catch (...) {
+				// the version is leaked rather than deleted while it may be read
+			}
+			reclaim();
+		}
+
+#if defined(__GNUC__) || defined(__clang__)
+		[[gnu::noinline, gnu::cold]]
+#endif
+		static const T* initialize() {
+			std::lock_guard<std::mutex> lk(writerLock);
+			if (auto* version = current.load(std::memory_order_seq_cst))
+				return version;
+			auto created = std::make_unique<T>();
+			onCreate();
+			current.store(created.get(), std::memory_order_seq_cst);
+			return created.release();
+		}
+	public:
+		SwappableSingleton() {
+			isLive.store(true, std::memory_order_relaxed);
+		}
+		~SwappableSingleton() {
+			isLive.store(false, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Read access to a version, which is not deleted while the snapshot exists
+		 * A snapshot must be destroyed on the thread that took it
+		 */
+		class Snapshot {
+		private:
+			const T* version;
+			Reader* reader;
+
+			Snapshot(const T* version, Reader* reader) noexcept : version(version), reader(reader) {}
+
+			friend class SwappableSingleton;
+		public:
+			Snapshot(Snapshot&& other) noexcept : version(other.version), reader(std::exchange(other.reader, nullptr)) {}
+			Snapshot(const Snapshot&) = delete;
+			Snapshot& operator=(const Snapshot&) = delete;
+			Snapshot& operator=(Snapshot&&) = delete;
+
+			~Snapshot() {
+				if (reader && --reader->nesting == 0)
+					reader->epoch.store(0, std::memory_order_release);
+			}
+
+			const T& operator*() const noexcept {
+				return *version;
+			}
+			const T* operator->() const noexcept {
+				return version;
+			}
+			const T* get() const noexcept {
+				return version;
+			}
+		};
+
+		/**
+		 * @return a snapshot of the current version
+		 */
+		static Snapshot get() {
+			auto& reader = threadReader();
+			if (reader.nesting++ == 0) {
+				// the seq_cst store is ordered before the load of current, which publish() relies on
+				reader.epoch.store(epoch.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+			}
+			Snapshot snapshot(current.load(std::memory_order_seq_cst), &reader);
+			if (!snapshot.version) [[unlikely]]
+				snapshot.version = initialize();
+			return snapshot;
+		}
+
+		/**
+		 * Atomically replaces the current version, snapshots taken before keep the old version
+		 * Deletes the old versions that are no longer read
+		 */
+		static void publish(std::unique_ptr<T> version) {
+			std::lock_guard<std::mutex> lk(writerLock);
+			retired.reserve(retired.size() + 1);
+			onCreate();
+			retire(current.exchange(version.release(), std::memory_order_seq_cst));
+			reclaim();
+		}
+
+		/**
+		 * Waits until every replaced version has been deleted
+		 * Must not be called by a thread that holds a snapshot
+		 */
+		static void synchronize() noexcept {
+			for (;;) {
+				{
+					std::lock_guard<std::mutex> lk(writerLock);
+					reclaim();
+					if (retired.empty())
+						return;
+				}
+				std::this_thread::yield();
+			}
+		}
+
+		/**
+		 * @return the amount of replaced versions that have not been deleted yet
+		 */
+		static std::size_t retiredVersions() {
+			std::lock_guard<std::mutex> lk(writerLock);
+			return retired.size();
+		}
+	};
+}
+#endif
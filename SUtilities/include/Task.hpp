@@ -0,0 +1,410 @@
+#pragma once
+#ifndef _TASK_H
+#define _TASK_H
+#include "Generator.hpp"
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+/**
+ * Lazy coroutine tasks and a single threaded event loop to run them on
+ * Usage:
+ *	- write a coroutine returning Task<R> that co_returns an R, and co_await other tasks or awaitables in it
+ *	- a task starts when it is awaited and resumes its awaiter when it finishes
+ *	- EventLoop::run(task) runs the task and every task spawned on the loop until they are all done
+ *	- co_await loop.schedule() suspends the current task so that other ready tasks can run
+ *	- an awaitable doing I/O on another thread resumes its awaiter with loop.post(handle)
+ * Coroutine frames are allocated with the FrameAllocator (see Generator.hpp)
+ */
+namespace SUtil {
+	template<typename R>
+	class Task;
+
+	/**
+	 * Not for external use
+	 */
+	namespace TaskTracker {
+		/**
+		 * Resumes the awaiter of a finished task, or returns to the resumer if there isn't one
+		 */
+		struct FinalAwaiter {
+			bool await_ready() const noexcept {
+				return false;
+			}
+
+			template<typename Promise>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> coroutine) noexcept {
+				if (auto continuation = coroutine.promise().continuation)
+					return continuation;
+				return std::noop_coroutine();
+			}
+
+			void await_resume() const noexcept {}
+		};
+
+		struct PromiseBase {
+			std::coroutine_handle<> continuation;
+			std::exception_ptr error;
+
+			std::suspend_always initial_suspend() const noexcept {
+				return {};
+			}
+
+			FinalAwaiter final_suspend() const noexcept {
+				return {};
+			}
+
+			void unhandled_exception() noexcept {
+				error = std::current_exception();
+			}
+
+			static void* operator new(std::size_t size) {
+				return FrameAllocator::allocate(size);
+			}
+
+			static void operator delete(void* ptr, std::size_t size) noexcept {
+				FrameAllocator::deallocate(ptr, size);
+			}
+		};
+
+		template<typename R>
+		struct Promise : PromiseBase {
+			std::optional<R> result;
+
+			Task<R> get_return_object() noexcept;
+
+			template<typename U = R>
+				requires std::constructible_from<R, U&&>
+			void return_value(U&& value) {
+				result.emplace(std::forward<U>(value));
+			}
+
+			R take() {
+				if (error)
+					std::rethrow_exception(error);
+				return std::move(*result);
+			}
+		};
+
+		template<>
+		struct Promise<void> : PromiseBase {
+			Task<void> get_return_object() noexcept;
+
+			void return_void() const noexcept {}
+
+			void take() const {
+				if (error)
+					std::rethrow_exception(error);
+			}
+		};
+	}
+
+	/**
+	 * A lazily started coroutine producing an R
+	 * @param <R> the result of the task, may be void
+	 */
+	template<typename R = void>
+	class Task {
+	public:
+		using promise_type = TaskTracker::Promise<R>;
+		using value_type = R;
+
+		Task(Task&& other) noexcept : coroutine(std::exchange(other.coroutine, nullptr)) {}
+
+		Task& operator=(Task&& other) noexcept {
+			std::swap(coroutine, other.coroutine);
+			return *this;
+		}
+
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+
+		~Task() {
+			if (coroutine)
+				coroutine.destroy();
+		}
+
+		/**
+		 * Starts the task, resuming the awaiter with its result once it is done
+		 * Rethrows the exception that ended the task if there was one
+		 */
+		auto operator co_await() && noexcept {
+			struct Awaiter {
+				std::coroutine_handle<promise_type> coroutine;
+
+				bool await_ready() const noexcept {
+					return coroutine.done();
+				}
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+					coroutine.promise().continuation = awaiter;
+					return coroutine;
+				}
+
+				R await_resume() {
+					return coroutine.promise().take();
+				}
+			};
+			return Awaiter{ coroutine };
+		}
+
+		auto operator co_await() & noexcept {
+			return std::move(*this).operator co_await();
+		}
+
+		bool done() const noexcept {
+			return coroutine.done();
+		}
+	private:
+		std::coroutine_handle<promise_type> coroutine;
+
+		explicit Task(std::coroutine_handle<promise_type> coroutine) noexcept : coroutine(coroutine) {}
+
+		friend promise_type;
+	};
+
+	template<typename R>
+	Task<R> TaskTracker::Promise<R>::get_return_object() noexcept {
+		return Task<R>(std::coroutine_handle<Promise>::from_promise(*this));
+	}
+
+	inline Task<void> TaskTracker::Promise<void>::get_return_object() noexcept {
+		return Task<void>(std::coroutine_handle<Promise>::from_promise(*this));
+	}
+
+	template<typename T>
+	struct is_task : std::false_type {};
+
+	template<typename R>
+	struct is_task<Task<R>> : std::true_type {};
+
+	template<typename T>
+	constexpr inline bool is_task_v = is_task<T>::value;
+
+	class EventLoop;
+
+	/**
+	 * Not for external use
+	 */
+	namespace TaskTracker {
+		/**
+		 * A coroutine owned by the event loop, which destroys itself when it finishes
+		 */
+		struct Detached {
+			struct promise_type {
+				EventLoop& loop;
+
+				template<typename ... Args>
+				explicit promise_type(EventLoop& loop, Args&...) noexcept : loop(loop) {}
+
+				Detached get_return_object() noexcept {
+					return { std::coroutine_handle<promise_type>::from_promise(*this) };
+				}
+
+				std::suspend_always initial_suspend() const noexcept {
+					return {};
+				}
+
+				inline std::suspend_never final_suspend() const noexcept;
+				inline void unhandled_exception() noexcept;
+
+				void return_void() const noexcept {}
+
+				static void* operator new(std::size_t size) {
+					return FrameAllocator::allocate(size);
+				}
+
+				static void operator delete(void* ptr, std::size_t size) noexcept {
+					FrameAllocator::deallocate(ptr, size);
+				}
+			};
+
+			std::coroutine_handle<promise_type> coroutine;
+		};
+
+		template<typename R>
+		using result_t = std::conditional_t<std::is_void_v<R>, std::monostate, R>;
+
+		/**
+		 * @param result where the result of the task is stored, may be nullptr
+		 */
+		template<typename R>
+		Detached runDetached(EventLoop&, Task<R> task, std::optional<result_t<R>>* result) {
+			if constexpr (std::is_void_v<R>) {
+				co_await std::move(task);
+				if (result)
+					result->emplace();
+			}
+			else {
+				auto value = co_await std::move(task);
+				if (result)
+					result->emplace(std::move(value));
+			}
+		}
+	}
+
+	/**
+	 * Runs tasks on the thread that calls run()
+	 * Only post() may be called from other threads
+	 */
+	class EventLoop {
+	private:
+		std::mutex lock;
+		std::condition_variable wake;
+		std::deque<std::coroutine_handle<>> ready;
+		/// spawned tasks that haven't finished, only used by the thread running the loop
+		std::size_t pending = 0;
+		std::exception_ptr error;
+
+		friend struct TaskTracker::Detached::promise_type;
+
+		void finished() noexcept {
+			--pending;
+		}
+
+		void fail(std::exception_ptr exception) noexcept {
+			if (!error)
+				error = std::move(exception);
+		}
+	public:
+		EventLoop() = default;
+		EventLoop(const EventLoop&) = delete;
+		EventLoop& operator=(const EventLoop&) = delete;
+
+		/**
+		 * Queues a suspended coroutine to be resumed by the loop, can be called from any thread
+		 */
+		void post(std::coroutine_handle<> coroutine) {
+			{
+				std::lock_guard<std::mutex> lk(lock);
+				ready.push_back(coroutine);
+			}
+			wake.notify_one();
+		}
+
+		/**
+		 * Queues the task to run concurrently with the other tasks of the loop
+		 * If it throws, run() rethrows the exception after every task finished
+		 */
+		template<typename R>
+		void spawn(Task<R> task) {
+			++pending;
+			post(TaskTracker::runDetached<R>(*this, std::move(task), nullptr).coroutine);
+		}
+
+		/**
+		 * @return an awaitable that suspends the awaiter and queues it behind the tasks that are ready
+		 */
+		auto schedule() noexcept {
+			struct Awaiter {
+				EventLoop& loop;
+
+				bool await_ready() const noexcept {
+					return false;
+				}
+
+				void await_suspend(std::coroutine_handle<> coroutine) {
+					loop.post(coroutine);
+				}
+
+				void await_resume() const noexcept {}
+			};
+			return Awaiter{ *this };
+		}
+
+		/**
+		 * Runs the task and all spawned tasks until they are done
+		 * Blocks while no task is ready until a task is posted
+		 * @return the result of the task
+		 */
+		template<typename R>
+		R run(Task<R> task) {
+			std::optional<TaskTracker::result_t<R>> result;
+			++pending;
+			post(TaskTracker::runDetached<R>(*this, std::move(task), &result).coroutine);
+			while (pending > 0) {
+				std::coroutine_handle<> next;
+				{
+					std::unique_lock<std::mutex> lk(lock);
+					wake.wait(lk, [this]() { return !ready.empty(); });
+					next = ready.front();
+					ready.pop_front();
+				}
+				next.resume();
+			}
+			if (error)
+				std::rethrow_exception(std::exchange(error, nullptr));
+			if constexpr (!std::is_void_v<R>)
+				return std::move(*result);
+		}
+	};
+
+	std::suspend_never TaskTracker::Detached::promise_type::final_suspend() const noexcept {
+		loop.finished();
+		return {};
+	}
+
+	void TaskTracker::Detached::promise_type::unhandled_exception() noexcept {
+		loop.fail(std::current_exception());
+	}
+
+	/**
+	 * Limits the amount of tasks of an event loop that hold a permit at the same time
+	 * Must only be used on the thread running the loop
+	 */
+	class AsyncSemaphore {
+	private:
+		EventLoop& loop;
+		std::size_t permits;
+		std::deque<std::coroutine_handle<>> waiters;
+	public:
+		AsyncSemaphore(EventLoop& loop, std::size_t permits) noexcept : loop(loop), permits(permits) {}
+
+		/**
+		 * @return an awaitable that resumes the awaiter once it holds a permit
+		 */
+		auto acquire() noexcept {
+			struct Awaiter {
+				AsyncSemaphore& semaphore;
+
+				bool await_ready() const noexcept {
+					if (semaphore.permits == 0)
+						return false;
+					--semaphore.permits;
+					return true;
+				}
+
+				void await_suspend(std::coroutine_handle<> coroutine) {
+					semaphore.waiters.push_back(coroutine);
+				}
+
+				void await_resume() const noexcept {}
+			};
+			return Awaiter{ *this };
+		}
+
+		/**
+		 * Gives the permit to the first waiter, which is resumed by the loop
+		 */
+		void release() {
+			if (waiters.empty()) {
+				++permits;
+				return;
+			}
+			auto next = waiters.front();
+			waiters.pop_front();
+			loop.post(next);
+		}
+
+		std::size_t available() const noexcept {
+			return permits;
+		}
+	};
+}
+#endif
@@ -0,0 +1,135 @@
+#pragma once
+#ifndef _TRAVERSAL_H
+#define _TRAVERSAL_H
+#include "Generator.hpp"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <ranges>
+#include <utility>
+#include <vector>
+/**
+ * Lazy tree traversal
+ * Usage:
+ *	- for (auto& node : traverse(root)) node.accept(visitor);
+ *	- children are found with node.children() by default, which must return a range of pointers (raw or smart)
+ *		or references to nodes. Pass a callable as the last argument to find them some other way
+ *	- null children are skipped
+ * traverse() does not recurse, so the depth of the tree is only limited by memory. Nodes are yielded as they
+ * are reached, so breaking out of the loop skips the rest of the tree. The children of a node are read
+ * after it is yielded. The only allocations are the recycled coroutine frame and the growth of the traversal stack
+ */
+namespace SUtil {
+	enum class TraversalOrder {
+		/// parents before their children
+		preOrder,
+		/// children before their parents
+		postOrder,
+		/// level by level
+		breadthFirst
+	};
+
+	/**
+	 * Gets the children of a node with its children() member function
+	 */
+	struct MemberChildren {
+		template<typename Node>
+			requires requires(Node& node) { node.children(); }
+		decltype(auto) operator()(Node& node) const {
+			return node.children();
+		}
+	};
+
+	/**
+	 * Not for external use
+	 */
+	namespace TraversalTracker {
+		/**
+		 * @return pointer to the node referred to by a child, nullptr for null pointers
+		 */
+		template<typename Node, typename Child>
+		Node* nodeOf(Child&& child) {
+			if constexpr (requires { *child; static_cast<bool>(child); }) {
+				return child ? std::addressof(*child) : nullptr;
+			}
+			else
+				return std::addressof(child);
+		}
+
+		/**
+		 * Pushes the children of the node so that the first child is on top of the stack
+		 */
+		template<typename Node, typename Element, typename Children, typename Make>
+		void pushChildren(std::vector<Element>& stack, Node& node, Children& children, Make&& make) {
+			const auto first = stack.size();
+			for (auto&& child : children(node)) {
+				if (auto* next = nodeOf<Node>(child))
+					stack.push_back(make(next));
+			}
+			std::reverse(stack.begin() + static_cast<std::ptrdiff_t>(first), stack.end());
+		}
+	}
+
+	/**
+	 * A callable that gets a range of the children of a Node
+	 */
+	template<typename C, typename Node>
+	concept ChildrenOf = std::invocable<C&, Node&> &&
+		std::ranges::input_range<std::invoke_result_t<C&, Node&>>;
+
+	/**
+	 * Lazily walks the tree rooted at root
+	 * @param order the order nodes are yielded in
+	 * @param children callable getting the children of a node
+	 * @return generator yielding a reference to every node of the tree
+	 */
+	template<typename Node, typename Children = MemberChildren>
+		requires ChildrenOf<Children, Node>
+	Generator<Node> traverse(Node& root, TraversalOrder order = TraversalOrder::preOrder, Children children = {}) {
+		using namespace TraversalTracker;
+		if (order == TraversalOrder::breadthFirst) {
+			std::vector<Node*> queue{ &root };
+			for (std::size_t head = 0; head < queue.size(); ++head) {
+				// drop the visited prefix once it is most of the queue
+				if (head >= 64 && head * 2 >= queue.size()) {
+					queue.erase(queue.begin(), queue.begin() + static_cast<std::ptrdiff_t>(head));
+					head = 0;
+				}
+				auto& node = *queue[head];
+				co_yield node;
+				for (auto&& child : children(node)) {
+					if (auto* next = nodeOf<Node>(child))
+						queue.push_back(next);
+				}
+			}
+		}
+		else if (order == TraversalOrder::preOrder) {
+			std::vector<Node*> stack{ &root };
+			while (!stack.empty()) {
+				auto& node = *stack.back();
+				stack.pop_back();
+				co_yield node;
+				pushChildren(stack, node, children, [](Node* next) { return next; });
+			}
+		}
+		else {
+			// a node is yielded the second time it is on top, after its children were pushed and yielded
+			std::vector<std::pair<Node*, bool>> stack{ { &root, false } };
+			while (!stack.empty()) {
+				auto& [node, expanded] = stack.back();
+				if (expanded) {
+					auto& visited = *node;
+					stack.pop_back();
+					co_yield visited;
+				}
+				else {
+					expanded = true;
+					auto& parent = *node;
+					pushChildren(stack, parent, children, [](Node* next) { return std::pair{ next, false }; });
+				}
+			}
+		}
+	}
+}
+#endif
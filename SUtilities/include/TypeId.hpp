@@ -0,0 +1,109 @@
+#pragma once
+#ifndef _TYPE_ID_H
+#define _TYPE_ID_H
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+/**
+ * Compile time type ids that do not need RTTI
+ * The id of a type is the address of a constexpr tag variable instantiated for that type, so ids
+ * can be compared in constant expressions and at runtime without typeid
+ * Usage:
+ *	- constexpr TypeId id = typeId<T>();
+ *	- id.name() is the name of the type as written by the compiler, for diagnostics only
+ *	- polymorphic types report the TypeId of their dynamic type with dynamicTypeId() (see Visitable.hpp)
+ * SUTIL_RTTI:
+ *	- 1 if the compiler generates RTTI, 0 if it is disabled (ie. -fno-rtti or /GR-)
+ *	- define it before including any SUtilities header to override the detection
+ *	- when 0, only RTTI free facilities are declared
+ * Ids are unique within a program. As with type_info, a type may get a different id in each shared library
+ * if the library hides its symbols
+ */
+#ifndef SUTIL_RTTI
+#if defined(__GXX_RTTI) || defined(_CPPRTTI) || defined(__cpp_rtti)
+#define SUTIL_RTTI 1
+#else
+#define SUTIL_RTTI 0
+#endif
+#endif
+namespace SUtil {
+	/**
+	 * Not for external use
+	 */
+	namespace TypeIdTracker {
+		/**
+		 * Extracts T from the signature of this function
+		 */
+		template<typename T>
+		constexpr std::string_view nameOf() noexcept {
+#if defined(__clang__) || defined(__GNUC__)
+			constexpr std::string_view signature = __PRETTY_FUNCTION__;
+			constexpr std::string_view prefix = "T = ";
+			constexpr auto start = signature.find(prefix) + prefix.size();
+			return signature.substr(start, signature.find_first_of(";]", start) - start);
+#elif defined(_MSC_VER)
+			constexpr std::string_view signature = __FUNCSIG__;
+			constexpr std::string_view prefix = "nameOf<";
+			constexpr auto start = signature.find(prefix) + prefix.size();
+			return signature.substr(start, signature.rfind(">(void)") - start);
+#else
+			return {};
+#endif
+		}
+
+		struct Tag {
+			std::string_view name;
+		};
+
+		template<typename T>
+		inline constexpr Tag tag{ nameOf<T>() };
+	}
+
+	class TypeId {
+	private:
+		const TypeIdTracker::Tag* tag = nullptr;
+
+		constexpr explicit TypeId(const TypeIdTracker::Tag* tag) noexcept : tag(tag) {}
+
+		template<typename T>
+		friend constexpr TypeId typeId() noexcept;
+	public:
+		/**
+		 * Constructs the null id, which is not the id of any type
+		 */
+		constexpr TypeId() noexcept = default;
+
+		constexpr std::string_view name() const noexcept {
+			return tag ? tag->name : std::string_view();
+		}
+
+		std::size_t hash() const noexcept {
+			return static_cast<std::size_t>(reinterpret_cast<std::uintptr_t>(tag) >> 3);
+		}
+
+		constexpr explicit operator bool() const noexcept {
+			return tag != nullptr;
+		}
+
+		friend constexpr bool operator==(TypeId, TypeId) noexcept = default;
+	};
+
+	/**
+	 * Gets the id of T, top level cv qualifiers are ignored like with typeid
+	 */
+	template<typename T>
+	constexpr TypeId typeId() noexcept {
+		return TypeId(&TypeIdTracker::tag<std::remove_cv_t<T>>);
+	}
+
+	/**
+	 * A type that can report the TypeId of its dynamic type
+	 */
+	template<typename T>
+	concept DynamicTypeIdentifiable = requires(const T & obj) {
+		{obj.dynamicTypeId()} -> std::same_as<TypeId>;
+	};
+}
+#endif
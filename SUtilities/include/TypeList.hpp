@@ -1,9 +1,15 @@
 #pragma once
 #ifndef _TYPELIST_H
 #define _TYPELIST_H
+#include "TypeId.hpp"
 #include <type_traits>
 #include <typeinfo>
 #include <concepts>
+#include <utility>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
 /**
  * Typelist facility
  * Concepts + Types:
@@ -12,7 +18,9 @@
  *	EmptyType - indicates end of type list
  *	TypeComparator + ComparisonResult - see below
  *	TemplateFunction - callable object with a templated operator() taking no arguments and returning void
- *	TypeInfoFunction - callable object accepting a const std::type_info& and returning void
+ *	TypeInfoFunction - callable object accepting a const std::type_info& and returning void (requires RTTI)
+ *	TypeIdFunction - callable object accepting a TypeId and returning void
+ *	indexOf<list>(obj) - index of the dynamic type of a polymorphic object in the list
  * 3 types of operations:
  *	- constexpr functions
  *		any operation that has a non-type result (ie size())
@@ -102,6 +110,7 @@ namespace TL {
 
 
 
+#if SUTIL_RTTI
 	/**
 	 * Functional version of get_t
 	 * Gets the std::type_info of the type at the specified index
@@ -115,6 +124,21 @@ namespace TL {
 	constexpr const std::type_info& getInfo<EmptyType>(unsigned index) {
 		return typeid(EmptyType);
 	}
+#endif
+
+	/**
+	 * Functional version of get_t that does not need RTTI
+	 * Gets the TypeId of the type at the specified index
+	 * Requires index < size (enforced by compiler)
+	 */
+	template<TListAny list>
+	constexpr SUtil::TypeId getId(unsigned index) {
+		return index == 0 ? SUtil::typeId<typename list::Value>() : getId<typename list::Next>(index - 1);
+	}
+	template<>
+	constexpr SUtil::TypeId getId<EmptyType>(unsigned) {
+		return SUtil::typeId<EmptyType>();
+	}
 
 
 
@@ -147,6 +171,125 @@ namespace TL {
 		return find<T, V>() != tl_npos;
 	}
 
+	/**
+	 * Not for external use
+	 */
+	namespace IndexTracker {
+		/// Identifies types by TypeId
+		struct IdKeys {
+			using Key = SUtil::TypeId;
+
+			template<typename T>
+			static Key of() noexcept {
+				return SUtil::typeId<T>();
+			}
+
+			static std::size_t hash(Key key) noexcept {
+				return key.hash();
+			}
+
+			static bool equivalent(Key, Key) noexcept {
+				return false;
+			}
+		};
+
+#if SUTIL_RTTI
+		/// Identifies types by the address of their type_info
+		struct InfoKeys {
+			using Key = const std::type_info*;
+
+			template<typename T>
+			static Key of() noexcept {
+				return &typeid(T);
+			}
+
+			static std::size_t hash(Key key) noexcept {
+				return static_cast<std::size_t>(reinterpret_cast<std::uintptr_t>(key) >> 3);
+			}
+
+			/// a type_info can have more than one address (ie. across shared libraries)
+			static bool equivalent(Key a, Key b) noexcept {
+				return *a == *b;
+			}
+		};
+#endif
+
+		/**
+		 * Maps the dynamic type of an object to its index in the type list
+		 * Types are looked up by key in an open addressing table, falling back to comparing every
+		 * type if keys of the same type can differ
+		 * @param <Keys> IdKeys or InfoKeys
+		 */
+		template<typename list, typename Keys>
+		class TypeIndexer {
+		private:
+			using Key = typename Keys::Key;
+			static constexpr std::size_t count = size<list>();
+			static constexpr std::size_t capacity = std::bit_ceil(count * 2);
+			std::array<Key, capacity> keys{};
+			std::array<unsigned, capacity> values{};
+			std::array<Key, count> types{};
+
+			static std::size_t hash(Key type) noexcept {
+				return Keys::hash(type) & (capacity - 1);
+			}
+
+			template<std::size_t ... Is>
+			TypeIndexer(std::index_sequence<Is...>) noexcept : types{ Keys::template of<get_t<list, Is>>()... } {
+				for (unsigned i = 0; i < count; ++i) {
+					auto slot = hash(types[i]);
+					while (keys[slot])
+						slot = (slot + 1) & (capacity - 1);
+					keys[slot] = types[i];
+					values[slot] = i;
+				}
+			}
+		public:
+			TypeIndexer() noexcept : TypeIndexer(std::make_index_sequence<count>{}) {}
+
+			/**
+			 * @return index of the type or tl_npos
+			 */
+			unsigned find(Key type) const noexcept {
+				if (!type)
+					return tl_npos;
+				for (auto slot = hash(type); keys[slot]; slot = (slot + 1) & (capacity - 1)) {
+					if (keys[slot] == type)
+						return values[slot];
+				}
+				for (unsigned i = 0; i < count; ++i) {
+					if (Keys::equivalent(types[i], type))
+						return i;
+				}
+				return tl_npos;
+			}
+
+			static const TypeIndexer& get() noexcept {
+				static const TypeIndexer indexer;
+				return indexer;
+			}
+		};
+	}
+
+	/**
+	 * Gets the index of the dynamic type of a polymorphic object in the list
+	 * Objects with dynamicTypeId() (see TypeId.hpp) are identified by it, other objects by typeid
+	 * @return index of the dynamic type of obj in list or tl_npos
+	 */
+	template<TList list, typename T>
+	unsigned indexOf(T& obj) noexcept {
+		if constexpr (SUtil::DynamicTypeIdentifiable<T>)
+			return IndexTracker::TypeIndexer<list, IndexTracker::IdKeys>::get().find(obj.dynamicTypeId());
+		else {
+#if SUTIL_RTTI
+			return IndexTracker::TypeIndexer<list, IndexTracker::InfoKeys>::get().find(&typeid(obj));
+#else
+			static_assert(SUtil::DynamicTypeIdentifiable<T>, "Without RTTI, operands must have dynamicTypeId()");
+			return tl_npos;
+#endif
+		}
+	}
+
 
 
 
@@ -226,30 +369,30 @@ namespace TL {
 	template<TListAny T, typename V, bool eraseAll>
 	struct EraseType {
 	private:
-		template<typename T, typename V, bool found, bool eraseAll>
+		template<typename L, typename U, bool found, bool all>
 		struct EraseTypeHelper;
 
-		template<typename T, typename V, bool eraseAll>
-		struct EraseTypeHelper<T, V, false, eraseAll> {
+		template<typename L, typename U, bool all>
+		struct EraseTypeHelper<L, U, false, all> {
 			// this node is not the node to erase
 			// push the head of the type list onto the body with the specified type erased
-			using Type = push_t<typename EraseType<typename T::Next, V, eraseAll>::Type, typename T::Value>;
+			using Type = push_t<typename EraseType<typename L::Next, U, all>::Type, typename L::Value>;
 		};
 
-		template<typename T, typename V>
-		struct EraseTypeHelper<T, V, true, false> {
+		template<typename L, typename U>
+		struct EraseTypeHelper<L, U, true, false> {
 			// this node is the value to erase and we only want to erase the 
 			// first occurence so return the rest of the list
-			using Type = typename T::Next;
+			using Type = typename L::Next;
 		};
-		template<typename T, typename V>
-		struct EraseTypeHelper<T, V, true, true> {
+		template<typename L, typename U>
+		struct EraseTypeHelper<L, U, true, true> {
 			// this node is the value to erase
 			// return the rest of the list with the specified type removed
-			using Type = typename EraseType<typename T::Next, V, true>::Type;
+			using Type = typename EraseType<typename L::Next, U, true>::Type;
 		};
-		template<typename V, bool found, bool eraseAll>
-		struct EraseTypeHelper<EmptyType, V, found, eraseAll> {
+		template<typename U, bool found, bool all>
+		struct EraseTypeHelper<EmptyType, U, found, all> {
 			// the list is empty
 			using Type = EmptyType;
 		};
@@ -305,11 +448,19 @@ namespace TL {
 		{a.template operator()<EmptyType>() } -> std::same_as<void>;
 	};
 
+#if SUTIL_RTTI
 	/// A Functor that accepts a type_info
 	template<typename T>
 	concept TypeInfoFunction = requires(T a) {
 		{a(typeid(int))} -> std::same_as<void>;
 	};
+#endif
+
+	/// A Functor that accepts a TypeId
+	template<typename T>
+	concept TypeIdFunction = requires(T a) {
+		{a(SUtil::typeId<int>())} -> std::same_as<void>;
+	};
 
 
 	template<typename T, TemplateFunction<EmptyType> function> requires std::is_same_v<T, EmptyType>
@@ -324,6 +475,7 @@ namespace TL {
 		for_each<typename list::Next>(std::forward<function>(f));
 	}
 
+#if SUTIL_RTTI
 	template<typename T, TypeInfoFunction function> requires std::is_same_v<T, EmptyType>
 	constexpr void for_each(function&& f) {}
 
@@ -335,6 +487,19 @@ namespace TL {
 		f(typeid(typename list::Value));
 		for_each<typename list::Next>(std::forward<function>(f));
 	}
+#endif
+
+	template<typename T, TypeIdFunction function> requires std::is_same_v<T, EmptyType>
+	constexpr void for_each(function&&) {}
+
+	/**
+	 * Iterates through all types in the type list passing the TypeId to the specified callable object
+	 */
+	template<TList list, TypeIdFunction function>
+	constexpr void for_each(function&& f) {
+		f(SUtil::typeId<typename list::Value>());
+		for_each<typename list::Next>(std::forward<function>(f));
+	}
 
 	/**
 	 * Increments a counter each time operator()<T>() is called
@@ -348,10 +513,10 @@ namespace TL {
 		constexpr unsigned getCount() { return count; }
 
 		template<typename V>
-		constexpr void operator()() { }
-
-		template<>
-		constexpr void operator() < T > () { ++count; }
+		constexpr void operator()() {
+			if constexpr (std::is_same_v<V, T>)
+				++count;
+		}
 	};
 	/**
 	 * Gets the amount of times T occurs in the list
@@ -371,7 +536,8 @@ namespace TL {
 	struct Replace {
 	private:
 		// don't replace this node
-		template<bool, bool continueReplacing>
+		// (the unused Dummy parameter allows partial specialization in class scope)
+		template<bool, bool continueReplacing, typename Dummy = void>
 		struct ReplaceHelper {
 			using Type = push_t<
 				typename Replace<typename list::Next, T, R, continueReplacing>::Type,
@@ -380,13 +546,13 @@ namespace TL {
 		};
 
 		// replace this node and don't replace all occurences
-		template<>
-		struct ReplaceHelper<true, false> {
+		template<typename Dummy>
+		struct ReplaceHelper<true, false, Dummy> {
 			using Type = push_t<typename list::Next, R>;
 		};
 		// replace this node and replace all occurences
-		template<>
-		struct ReplaceHelper<true, true> {
+		template<typename Dummy>
+		struct ReplaceHelper<true, true, Dummy> {
 			using Type = push_t<
 				typename Replace<typename list::Next, T, R, true>::Type, 
 				R
@@ -450,13 +616,13 @@ namespace TL {
 		requires TypeComparator<cmp<T, U>>
 	struct Less {
 	private:
-		template<ComparisonResult res>
+		template<ComparisonResult res, typename Dummy = void>
 		struct LessHelper {
 			using Type = T;
 		};
 
-		template<>
-		struct LessHelper<ComparisonResult::greater> {
+		template<typename Dummy>
+		struct LessHelper<ComparisonResult::greater, Dummy> {
 			using Type = U;
 		};
 	public:
@@ -490,14 +656,14 @@ namespace TL {
 		using prev = typename OrderedInsert<typename list::Next, typename list::Value, comp>::Type;
 
 		// new value is less than current head, push it on the rest of the list
-		template<ComparisonResult>
+		template<ComparisonResult, typename Dummy = void>
 		struct InsertHelper {
 			using Type = push_t<prev, T>;
 		};
 
 		// new value is greater than list head, insert it into proper place in the list
-		template<>
-		struct InsertHelper<ComparisonResult::greater> {
+		template<typename Dummy>
+		struct InsertHelper<ComparisonResult::greater, Dummy> {
 			using Type = typename Push<
 				typename OrderedInsert<typename prev::Next, T, comp>::Type, 
 				typename prev::Value
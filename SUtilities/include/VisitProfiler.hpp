@@ -0,0 +1,388 @@
+#pragma once
+#ifndef _VISIT_PROFILER_H
+#define _VISIT_PROFILER_H
+#include "TypeId.hpp"
+#include "Visitor.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#if SUTIL_RTTI
+#include <typeinfo>
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#endif
+#endif
+/**
+ * Profiler of visitor dispatch
+ * Usage:
+ *	- define SUTIL_PROFILE_VISITS to 1 for every translation unit (ie. as a compile definition) to instrument
+ *		BaseVisitable::acceptImpl. When it is 0 (the default) visits are not instrumented at all
+ *	- every accept() counts a call for its (dynamic visitor type, visited type) pair and every
+ *		sampling interval calls of a thread, the latency of the call is recorded in a histogram
+ *	- visitProfile() merges the counters of all threads, sorted by the estimated cumulative time
+ *	- the report is printed to stderr at exit, disable it with setVisitProfileReport(false)
+ * Times are inclusive: a visit that visits other objects also counts the time of the nested visits
+ * Counters are thread local, so recording a visit takes no lock unless the thread sees a pair for the
+ * first time. Visitors are named by their RTTI name, or their dispatch table without RTTI
+ */
+#ifndef SUTIL_PROFILE_VISITS
+#define SUTIL_PROFILE_VISITS 0
+#endif
+namespace SUtil {
+	/// bucket i of a latency histogram counts samples that took [2^(i - 1), 2^i) nanoseconds, the last is unbounded
+	constexpr inline std::size_t visitProfileBuckets = 32;
+
+	/**
+	 * The merged counters of a (visitor type, visited type) pair
+	 */
+	struct VisitProfileEntry {
+		std::string visitor;
+		std::string_view visited;
+		std::uint64_t calls;
+		std::uint64_t samples;
+		std::uint64_t sampledNanos;
+		std::array<std::uint64_t, visitProfileBuckets> histogram;
+
+		double meanNanos() const noexcept {
+			return samples == 0 ? 0.0 : static_cast<double>(sampledNanos) / static_cast<double>(samples);
+		}
+
+		/**
+		 * @return the time of all calls, extrapolated from the samples
+		 */
+		double totalNanos() const noexcept {
+			return meanNanos() * static_cast<double>(calls);
+		}
+
+		/**
+		 * @param fraction in [0, 1]
+		 * @return upper bound of the latency of the given fraction of the samples
+		 */
+		std::uint64_t percentileNanos(double fraction) const noexcept {
+			const auto target = static_cast<std::uint64_t>(fraction * static_cast<double>(samples));
+			std::uint64_t seen = 0;
+			for (std::size_t i = 0; i < visitProfileBuckets; ++i) {
+				seen += histogram[i];
+				if (seen > target || (seen == samples && seen != 0))
+					return std::uint64_t{ 1 } << i;
+			}
+			return 0;
+		}
+	};
+
+	/**
+	 * Not for external use
+	 */
+	namespace VisitProfilerTracker {
+		struct PairKey {
+			/// the type_info of the visitor, or its dispatch table without RTTI
+			const void* visitor;
+			TypeId visited;
+
+			friend bool operator==(const PairKey&, const PairKey&) noexcept = default;
+		};
+
+		struct PairHash {
+			std::size_t operator()(const PairKey& key) const noexcept {
+				const auto visitor = static_cast<std::size_t>(reinterpret_cast<std::uintptr_t>(key.visitor) >> 3);
+				return visitor * 31 + key.visited.hash();
+			}
+		};
+
+		/**
+		 * Written by the owning thread only, read by any thread merging the profile
+		 */
+		struct Counters {
+			std::atomic<std::uint64_t> calls{ 0 };
+			std::atomic<std::uint64_t> samples{ 0 };
+			std::atomic<std::uint64_t> sampledNanos{ 0 };
+			std::array<std::atomic<std::uint64_t>, visitProfileBuckets> histogram{};
+
+			/// single writer, so a load and a store is enough
+			static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t amount) noexcept {
+				counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+			}
+
+			void reset() noexcept {
+				calls.store(0, std::memory_order_relaxed);
+				samples.store(0, std::memory_order_relaxed);
+				sampledNanos.store(0, std::memory_order_relaxed);
+				for (auto& bucket : histogram)
+					bucket.store(0, std::memory_order_relaxed);
+			}
+		};
+
+		struct Totals {
+			std::uint64_t calls = 0;
+			std::uint64_t samples = 0;
+			std::uint64_t sampledNanos = 0;
+			std::array<std::uint64_t, visitProfileBuckets> histogram{};
+
+			void add(const Counters& counters) noexcept {
+				calls += counters.calls.load(std::memory_order_relaxed);
+				samples += counters.samples.load(std::memory_order_relaxed);
+				sampledNanos += counters.sampledNanos.load(std::memory_order_relaxed);
+				for (std::size_t i = 0; i < visitProfileBuckets; ++i)
+					histogram[i] += counters.histogram[i].load(std::memory_order_relaxed);
+			}
+		};
+
+		using TotalsMap = std::unordered_map<PairKey, Totals, PairHash>;
+
+		inline std::string visitorName(const void* visitor) {
+#if SUTIL_RTTI
+			const char* name = static_cast<const std::type_info*>(visitor)->name();
+#if defined(__GNUC__) || defined(__clang__)
+			int status = 0;
+			std::unique_ptr<char, void(*)(void*)> demangled(
+				abi::__cxa_demangle(name, nullptr, nullptr, &status), std::free);
+			if (status == 0 && demangled)
+				return demangled.get();
+#endif
+			return name;
+#else
+			std::ostringstream ss;
+			ss << "visitor with dispatch table " << visitor;
+			return ss.str();
+#endif
+		}
+
+		/**
+		 * @return an entry per pair that was visited, the most expensive first
+		 */
+		inline std::vector<VisitProfileEntry> entriesOf(const TotalsMap& totals) {
+			std::vector<VisitProfileEntry> entries;
+			for (const auto& [key, pair] : totals) {
+				if (pair.calls != 0)
+					entries.push_back({ visitorName(key.visitor), key.visited.name(),
+						pair.calls, pair.samples, pair.sampledNanos, pair.histogram });
+			}
+			std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+				return a.totalNanos() > b.totalNanos();
+			});
+			return entries;
+		}
+
+		class ThreadProfile;
+
+		class Registry {
+		private:
+			std::mutex lock;
+			std::vector<ThreadProfile*> threads;
+			/// counters of the threads that have exited
+			TotalsMap retired;
+		public:
+			/// calls that are not timed between two timed calls
+			std::atomic<std::uint32_t> skippedPerSample{ 15 };
+			std::atomic<bool> reportAtExit{ true };
+
+			void attach(ThreadProfile* thread) {
+				std::lock_guard<std::mutex> lk(lock);
+				threads.push_back(thread);
+			}
+
+			inline void detach(ThreadProfile* thread);
+			inline TotalsMap merge();
+			inline void reset();
+
+			inline ~Registry();
+		};
+
+		inline Registry& registry() {
+			static Registry instance;
+			return instance;
+		}
+
+		class ThreadProfile {
+		private:
+			/// guards the structure of pairs, which is only changed by the owning thread
+			std::mutex lock;
+			std::unordered_map<PairKey, Counters, PairHash> pairs;
+			PairKey lastKey{ nullptr, {} };
+			Counters* last = nullptr;
+			std::uint32_t untilSample = 0;
+			friend class Registry;
+		public:
+			ThreadProfile() {
+				registry().attach(this);
+			}
+
+			~ThreadProfile() {
+				registry().detach(this);
+			}
+
+			Counters& find(const PairKey& key) {
+				if (last && lastKey == key) [[likely]]
+					return *last;
+				auto it = pairs.find(key);
+				if (it == pairs.end()) {
+					std::lock_guard<std::mutex> lk(lock);
+					it = pairs.try_emplace(key).first;
+				}
+				lastKey = key;
+				last = &it->second;
+				return *last;
+			}
+
+			/**
+			 * @return true if the next call should be timed
+			 */
+			bool sample() noexcept {
+				if (untilSample == 0) {
+					untilSample = registry().skippedPerSample.load(std::memory_order_relaxed);
+					return true;
+				}
+				--untilSample;
+				return false;
+			}
+
+			static ThreadProfile& current() {
+				thread_local ThreadProfile profile;
+				return profile;
+			}
+		};
+
+		void Registry::detach(ThreadProfile* thread) {
+			std::lock_guard<std::mutex> lk(lock);
+			for (const auto& [key, counters] : thread->pairs)
+				retired[key].add(counters);
+			threads.erase(std::find(threads.begin(), threads.end(), thread));
+		}
+
+		TotalsMap Registry::merge() {
+			std::lock_guard<std::mutex> lk(lock);
+			auto totals = retired;
+			for (auto* thread : threads) {
+				std::lock_guard<std::mutex> threadLock(thread->lock);
+				for (const auto& [key, counters] : thread->pairs)
+					totals[key].add(counters);
+			}
+			return totals;
+		}
+
+		void Registry::reset() {
+			std::lock_guard<std::mutex> lk(lock);
+			retired.clear();
+			for (auto* thread : threads) {
+				std::lock_guard<std::mutex> threadLock(thread->lock);
+				for (auto& [key, counters] : thread->pairs)
+					counters.reset();
+			}
+		}
+
+		/**
+		 * Counts a visit and times it if it is sampled
+		 */
+		class ScopedVisit {
+		private:
+			Counters& counters;
+			std::chrono::steady_clock::time_point start;
+			bool sampled;
+		public:
+			ScopedVisit(const BaseVisitor& visitor, TypeId visited) :
+#if SUTIL_RTTI
+				ScopedVisit(ThreadProfile::current(), { &typeid(visitor), visited }) {}
+#else
+				ScopedVisit(ThreadProfile::current(), { visitor.dispatchTable(), visited }) {}
+#endif
+
+			ScopedVisit(ThreadProfile& profile, const PairKey& key) :
+				counters(profile.find(key)), sampled(profile.sample()) {
+				Counters::bump(counters.calls, 1);
+				if (sampled)
+					start = std::chrono::steady_clock::now();
+			}
+
+			~ScopedVisit() {
+				if (!sampled)
+					return;
+				const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - start).count();
+				const auto nanos = static_cast<std::uint64_t>(elapsed > 0 ? elapsed : 0);
+				const auto bucket = std::min<std::size_t>(std::bit_width(nanos), visitProfileBuckets - 1);
+				Counters::bump(counters.samples, 1);
+				Counters::bump(counters.sampledNanos, nanos);
+				Counters::bump(counters.histogram[bucket], 1);
+			}
+
+			ScopedVisit(const ScopedVisit&) = delete;
+			ScopedVisit& operator=(const ScopedVisit&) = delete;
+		};
+	}
+
+	/**
+	 * Merges the counters of all threads
+	 * @return one entry per (visitor type, visited type) pair, the most expensive first
+	 */
+	inline std::vector<VisitProfileEntry> visitProfile() {
+		return VisitProfilerTracker::entriesOf(VisitProfilerTracker::registry().merge());
+	}
+
+	/**
+	 * Zeroes the counters of all threads
+	 */
+	inline void resetVisitProfile() {
+		VisitProfilerTracker::registry().reset();
+	}
+
+	/**
+	 * Times one out of every interval visits of each thread, 1 times every visit
+	 */
+	inline void setVisitProfileSampling(std::uint32_t interval) {
+		VisitProfilerTracker::registry().skippedPerSample.store(interval > 0 ? interval - 1 : 0,
+			std::memory_order_relaxed);
+	}
+
+	/**
+	 * Enables or disables the report printed at exit
+	 */
+	inline void setVisitProfileReport(bool enabled) {
+		VisitProfilerTracker::registry().reportAtExit.store(enabled, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Prints one line per pair, the most expensive first
+	 */
+	inline void printVisitProfile(std::ostream& out, const std::vector<VisitProfileEntry>& entries) {
+		out << std::setw(12) << "total ms" << std::setw(12) << "calls" << std::setw(10) << "mean ns"
+			<< std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns" << "  visitor -> visited\n";
+		for (const auto& entry : entries) {
+			out << std::fixed << std::setprecision(3) << std::setw(12) << entry.totalNanos() / 1e6
+				<< std::setw(12) << entry.calls << std::setprecision(1) << std::setw(10) << entry.meanNanos()
+				<< std::setw(10) << entry.percentileNanos(0.5) << std::setw(10) << entry.percentileNanos(0.99)
+				<< "  " << entry.visitor << " -> " << entry.visited << '\n';
+		}
+		out << std::defaultfloat;
+	}
+
+	inline void printVisitProfile(std::ostream& out) {
+		printVisitProfile(out, visitProfile());
+	}
+
+	VisitProfilerTracker::Registry::~Registry() {
+		if (!reportAtExit.load(std::memory_order_relaxed))
+			return;
+		// the profile of the main thread was retired when its thread locals were destroyed
+		const auto entries = entriesOf(retired);
+		if (entries.empty())
+			return;
+		std::cerr << "Visit profile\n";
+		printVisitProfile(std::cerr, entries);
+	}
+}
+#endif
@@ -1,22 +1,74 @@
 #pragma once
 #ifndef _VISITABLE_H
 #define _VISITABLE_H
+#include "TypeId.hpp"
 #include "Visitor.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <concepts>
+#include <cstdint>
 #include <exception>
+#include <mutex>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <variant>
+#include <vector>
+#if defined(SUTIL_PROFILE_VISITS) && SUTIL_PROFILE_VISITS
+#include "VisitProfiler.hpp"
+#endif
 /**
  * UnknownVisitorPolicy:
  *	- the policy that dictates the behavior when an unknown type is visited by a visitors
+ *	- onUnknownVisitor() may take a const VisitError& describing the failed visit
+ *	- DefaultConstruct: returns ReturnType()
+ *	- Exception: throws an UnknownVisitorException
+ *	- Expected: returns the error in a VisitResult, ReturnType must be a VisitResult<> and so must be the
+ *		return type of the visitors. Use tryAcceptAll() (see VisitorAlgorithms.hpp) to count the failed visits of a range
+ *	- Sentinel: SentinelUnknownPolicy<value>::Policy returns value converted to ReturnType
+ *	- the unknown visitor path is marked cold so that the dispatch of a known visitor stays on the hot path
  * Usage:
  *  - make any class you wish to be able to visit inherit from BaseVisitable<>
  *  - add the macro MAKE_VISITABLE(ReturnType) to the public section of the class definition
  *  - for visitors that do not mutate, inherit from Vistitor with the const modifier applied to the class to visit
  *  - for visitables that can accept const visitors, inherit from ImmutableBaseVisitable<> and use the macro MAKE_CONST_VISITABLE
+ * VisitorDispatchPolicy:
+ *	- how accept() finds the visit function of the visitor
+ *		- DynamicCast: cross cast the visitor to the VisitorSingle of the visited type
+ *		- Table: a single lookup in the flat dispatch table of the visitor
+ *		- Cached: DynamicCast that remembers the result for each dynamic visitor type
+ *		- DynamicCast and Cached look in the dispatch table as a last resort, CompactVisitors are found there
+ *		- DynamicCast and Cached need RTTI. Without RTTI (see TypeId.hpp) the default is Table, and visitors
+ *			must subtype Visitor<>
+ * MAKE_VISITABLE also overrides dynamicTypeId(), the RTTI free id of the dynamic type of a visitable
+ *	- a class using MAKE_CONST_VISITABLE or MAKE_MUTABLE_VISITABLE instead adds the macro VISITABLE_TYPE_ID for it
+ * Define SUTIL_PROFILE_VISITS to 1 to profile every accept() (see VisitProfiler.hpp)
+ */
+/**
+ * Marks a function as unlikely to be called, keeping it out of line and away from the hot code
  */
+#if defined(__GNUC__) || defined(__clang__)
+#define SUTIL_COLD [[gnu::cold, gnu::noinline]]
+#elif defined(_MSC_VER)
+#define SUTIL_COLD __declspec(noinline)
+#else
+#define SUTIL_COLD
+#endif
 namespace SUtil {
+	/**
+	 * Describes a visit that the visitor could not handle
+	 */
+	struct VisitError {
+		/// the static type of the visited object when it called accept, the null id if unknown
+		TypeId visited;
+	};
+
 	template<template <typename> typename T, typename ReturnType>
-	concept UnknownVisitorPolicy = requires(T<ReturnType> a) {
+	concept UnknownVisitorPolicy = requires {
 		{T<ReturnType>::onUnknownVisitor()} -> std::same_as<ReturnType>;
+	} || requires(const VisitError& error) {
+		{T<ReturnType>::onUnknownVisitor(error)} -> std::same_as<ReturnType>;
 	};
 
 	template<typename ReturnType>
@@ -29,7 +81,7 @@ namespace SUtil {
 
 	class UnknownVisitorException : public std::exception {
 	public:
-		const char* what() const override {
+		const char* what() const noexcept override {
 			return "Visitor has visited an unknown type";
 		}
 	};
@@ -37,11 +89,492 @@ namespace SUtil {
 	template<typename ReturnType>
 	class ExceptionUnknownPolicy {
 	public:
-		static ReturnType onUnknownVisitor() {
+		SUTIL_COLD static ReturnType onUnknownVisitor() {
 			throw UnknownVisitorException();
 		}
 	};
 
+	/**
+	 * The result of a visit or the reason it failed, an exception free alternative to ExceptionUnknownPolicy
+	 * Implicitly constructible from a ReturnType (or a value convertible to one) and from a VisitError
+	 * @param <ReturnType> the result of a successful visit, may be void
+	 */
+	template<typename ReturnType>
+	class VisitResult {
+	private:
+		std::variant<ReturnType, VisitError> result;
+	public:
+		using value_type = ReturnType;
+
+		VisitResult() requires std::default_initializable<ReturnType> = default;
+
+		template<typename U = ReturnType>
+			requires std::constructible_from<ReturnType, U&&> &&
+				(!std::same_as<std::remove_cvref_t<U>, VisitResult>) &&
+				(!std::same_as<std::remove_cvref_t<U>, VisitError>)
+		VisitResult(U&& value) : result(std::in_place_index<0>, std::forward<U>(value)) {}
+
+		VisitResult(const VisitError& error) noexcept : result(std::in_place_index<1>, error) {}
+
+		bool has_value() const noexcept {
+			return result.index() == 0;
+		}
+
+		explicit operator bool() const noexcept {
+			return has_value();
+		}
+
+		/**
+		 * @throw UnknownVisitorException if the visit failed
+		 */
+		ReturnType& value() & {
+			if (!has_value()) [[unlikely]]
+				throw UnknownVisitorException();
+			return *std::get_if<0>(&result);
+		}
+
+		const ReturnType& value() const & {
+			if (!has_value()) [[unlikely]]
+				throw UnknownVisitorException();
+			return *std::get_if<0>(&result);
+		}
+
+		ReturnType&& value() && {
+			return std::move(value());
+		}
+
+		/**
+		 * Unchecked access to the result of a successful visit
+		 */
+		ReturnType& operator*() & noexcept {
+			return *std::get_if<0>(&result);
+		}
+
+		const ReturnType& operator*() const & noexcept {
+			return *std::get_if<0>(&result);
+		}
+
+		ReturnType&& operator*() && noexcept {
+			return std::move(*std::get_if<0>(&result));
+		}
+
+		ReturnType* operator->() noexcept {
+			return std::get_if<0>(&result);
+		}
+
+		const ReturnType* operator->() const noexcept {
+			return std::get_if<0>(&result);
+		}
+
+		/**
+		 * Unchecked access to the error of a failed visit
+		 */
+		const VisitError& error() const noexcept {
+			return *std::get_if<1>(&result);
+		}
+
+		template<typename U>
+		ReturnType value_or(U&& fallback) const & {
+			return has_value() ? **this : static_cast<ReturnType>(std::forward<U>(fallback));
+		}
+
+		template<typename U>
+		ReturnType value_or(U&& fallback) && {
+			return has_value() ? std::move(**this) : static_cast<ReturnType>(std::forward<U>(fallback));
+		}
+	};
+
+	template<>
+	class VisitResult<void> {
+	private:
+		VisitError failure;
+		bool failed = false;
+	public:
+		using value_type = void;
+
+		VisitResult() noexcept = default;
+		VisitResult(const VisitError& error) noexcept : failure(error), failed(true) {}
+
+		bool has_value() const noexcept {
+			return !failed;
+		}
+
+		explicit operator bool() const noexcept {
+			return has_value();
+		}
+
+		/**
+		 * @throw UnknownVisitorException if the visit failed
+		 */
+		void value() const {
+			if (failed) [[unlikely]]
+				throw UnknownVisitorException();
+		}
+
+		void operator*() const noexcept {}
+
+		const VisitError& error() const noexcept {
+			return failure;
+		}
+	};
+
+	template<typename T>
+	struct is_visit_result : std::false_type {};
+
+	template<typename T>
+	struct is_visit_result<VisitResult<T>> : std::true_type {};
+
+	template<typename T>
+	constexpr inline bool is_visit_result_v = is_visit_result<T>::value;
+
+	/**
+	 * Returns the VisitError instead of throwing
+	 * @param <ReturnType> a VisitResult<>
+	 */
+	template<typename ReturnType>
+	class ExpectedUnknownPolicy {
+		static_assert(is_visit_result_v<ReturnType>, "ExpectedUnknownPolicy needs a VisitResult<> return type");
+	public:
+		SUTIL_COLD static ReturnType onUnknownVisitor(const VisitError& error) noexcept {
+			return ReturnType(error);
+		}
+	};
+
+	/**
+	 * Returns a caller supplied sentinel value
+	 * Usage: BaseVisitable<int, SentinelUnknownPolicy<-1>::Policy>
+	 * @param <sentinel> the value returned by unknown visits, must be convertible to ReturnType
+	 */
+	template<auto sentinel>
+	struct SentinelUnknownPolicy {
+		template<typename ReturnType>
+		class Policy {
+		public:
+			SUTIL_COLD static ReturnType onUnknownVisitor() noexcept {
+				return static_cast<ReturnType>(sentinel);
+			}
+		};
+	};
+
+	/**
+	 * Requires a static dispatch function that calls the visit function of the visitor
+	 * or the unknown visitor policy if the visitor cannot visit the type
+	 */
+	template<typename T, typename ReturnType>
+	concept VisitorDispatchPolicy = requires(int& visited, BaseVisitor& visitor) {
+		{T::template dispatch<ReturnType, DefaultConstructUnknownPolicy>(visited, visitor)}
+			-> std::same_as<ReturnType>;
+	};
+
+	/**
+	 * Not for external use
+	 */
+	namespace VisitorDispatchTracker {
+		/**
+		 * Calls the unknown visitor policy, passing it the error if it takes one
+		 */
+		template<typename ReturnType, template<typename> typename up>
+		SUTIL_COLD ReturnType unknownVisit(const VisitError& error) {
+			if constexpr (requires { up<ReturnType>::onUnknownVisitor(error); })
+				return up<ReturnType>::onUnknownVisitor(error);
+			else
+				return up<ReturnType>::onUnknownVisitor();
+		}
+
+		/**
+		 * Calls the visit function in the dispatch table of the visitor or the unknown visitor policy
+		 * Used after the VisitorSingle bases of the visitor have been searched, so that visitors without
+		 * them (ie. CompactVisitor) can still be visited
+		 */
+		template<typename ReturnType, template<typename> typename up, typename T>
+		ReturnType visitFromTable(T& visited, BaseVisitor& base) {
+			if (auto thunk = findThunk<T, ReturnType>(base)) [[likely]]
+				return thunk(base, const_cast<void*>(static_cast<const void*>(&visited)));
+			return unknownVisit<ReturnType, up>({ typeId<T>() });
+		}
+	}
+
+#if SUTIL_RTTI
+	struct DynamicCastDispatchPolicy {
+		template<typename ReturnType, template<typename> typename up, typename T>
+		static ReturnType dispatch(T& visited, BaseVisitor& base) {
+			// the casts would fail for a CompactVisitor, which has no VisitorSingle bases
+			if (const auto* table = base.dispatchTable(); table && table->tableOnly()) {
+				if (auto thunk = table->template find<ReturnType>(dispatchId<T, ReturnType>()))
+					return thunk(base, const_cast<void*>(static_cast<const void*>(&visited)));
+			}
+			if (auto* v =
+				dynamic_cast<VisitorSingle<T, ReturnType>*>(&base)) {
+				return v->visit(visited);
+			}
+			else if (auto* v =
+				dynamic_cast<VisitorSingle<std::add_const_t<T>, ReturnType>*>(&base)) {
+				// cast should work if the visitor is const but the visited is mutable
+				return v->visit(visited);
+			}
+			return VisitorDispatchTracker::visitFromTable<ReturnType, up>(visited, base);
+		}
+	};
+#endif
+
+	/**
+	 * Looks up the visit function in the dispatch table of the visitor
+	 * Falls back to a dynamic_cast when the visitor has no table entry for the type,
+	 * ie. visitors that do not subtype Visitor<> or that add VisitorSingle bases of their own
+	 * Without RTTI, there is no fallback and the unknown visitor policy is used instead
+	 */
+	struct TableDispatchPolicy {
+		template<typename ReturnType, template<typename> typename up, typename T>
+		static ReturnType dispatch(T& visited, BaseVisitor& base) {
+			if (auto thunk = VisitorDispatchTracker::findThunk<T, ReturnType>(base)) [[likely]] {
+				return thunk(base, const_cast<void*>(static_cast<const void*>(&visited)));
+			}
+#if SUTIL_RTTI
+			return DynamicCastDispatchPolicy::dispatch<ReturnType, up>(visited, base);
+#else
+			return VisitorDispatchTracker::unknownVisit<ReturnType, up>({ typeId<T>() });
+#endif
+		}
+	};
+
+#if SUTIL_RTTI
+	using DefaultDispatchPolicy = DynamicCastDispatchPolicy;
+#else
+	using DefaultDispatchPolicy = TableDispatchPolicy;
+#endif
+
+#if SUTIL_RTTI
+	/**
+	 * Hit and miss counters of all CachedDispatchPolicy caches
+	 */
+	struct DispatchCacheStats {
+		std::uint64_t hits;
+		std::uint64_t misses;
+
+		double hitRate() const noexcept {
+			const auto total = hits + misses;
+			return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+		}
+	};
+
+	/**
+	 * Not for external use
+	 */
+	namespace DispatchCacheTracker {
+		class ThreadCounters;
+
+		/**
+		 * The counters of every thread, merged when the stats are read
+		 */
+		class Registry {
+		private:
+			std::mutex lock;
+			std::vector<ThreadCounters*> threads;
+			/// counts of the threads that have exited
+			DispatchCacheStats retired{ 0, 0 };
+			/// the totals when the stats were last reset, the counters themselves are only written by their thread
+			DispatchCacheStats baseline{ 0, 0 };
+
+			/**
+			 * Requires the lock to be held
+			 */
+			DispatchCacheStats totals() const noexcept;
+		public:
+			void attach(ThreadCounters* thread) {
+				std::lock_guard<std::mutex> lk(lock);
+				threads.push_back(thread);
+			}
+			inline void detach(ThreadCounters* thread) noexcept;
+			inline DispatchCacheStats merge();
+			inline void reset();
+		};
+
+		inline Registry& registry() {
+			static Registry instance;
+			return instance;
+		}
+
+		/**
+		 * Written by the owning thread only, so that a dispatch does not write a cache line shared between threads
+		 */
+		class ThreadCounters {
+		public:
+			std::atomic<std::uint64_t> hits{ 0 };
+			std::atomic<std::uint64_t> misses{ 0 };
+
+			ThreadCounters() {
+				registry().attach(this);
+			}
+			~ThreadCounters() {
+				registry().detach(this);
+			}
+
+			/// single writer, so a load and a store is enough
+			static void bump(std::atomic<std::uint64_t>& counter) noexcept {
+				counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			}
+
+			static ThreadCounters& current() {
+				thread_local ThreadCounters counters;
+				return counters;
+			}
+		};
+
+		void Registry::detach(ThreadCounters* thread) noexcept {
+			std::lock_guard<std::mutex> lk(lock);
+			retired.hits += thread->hits.load(std::memory_order_relaxed);
+			retired.misses += thread->misses.load(std::memory_order_relaxed);
+			threads.erase(std::find(threads.begin(), threads.end(), thread));
+		}
+
+		inline DispatchCacheStats Registry::totals() const noexcept {
+			auto totals = retired;
+			for (auto* thread : threads) {
+				totals.hits += thread->hits.load(std::memory_order_relaxed);
+				totals.misses += thread->misses.load(std::memory_order_relaxed);
+			}
+			return totals;
+		}
+
+		DispatchCacheStats Registry::merge() {
+			std::lock_guard<std::mutex> lk(lock);
+			const auto current = totals();
+			return { current.hits - baseline.hits, current.misses - baseline.misses };
+		}
+
+		void Registry::reset() {
+			std::lock_guard<std::mutex> lk(lock);
+			baseline = totals();
+		}
+
+		enum class CachedVisit : unsigned char {
+			unknown,
+			/// visit through VisitorSingle<T, ReturnType>
+			exact,
+			/// visit through VisitorSingle<const T, ReturnType>
+			constant
+		};
+
+		/**
+		 * Fixed size open addressing map from the dynamic type of a visitor to the offset of its
+		 * VisitorSingle subobject from the most derived object. Lookups are lock free, insertions take a lock.
+		 * A slot is never changed once its key is published
+		 */
+		template<std::size_t capacity>
+		class DispatchCache {
+		public:
+			struct Slot {
+				std::atomic<const std::type_info*> visitorType{ nullptr };
+				std::ptrdiff_t offset = 0;
+				CachedVisit visit = CachedVisit::unknown;
+			};
+		private:
+			std::array<Slot, capacity> slots;
+			std::mutex insertLock;
+
+			static std::size_t hash(const std::type_info* type) noexcept {
+				// type_info objects are at least pointer aligned
+				return (reinterpret_cast<std::uintptr_t>(type) >> 3) & (capacity - 1);
+			}
+		public:
+			/**
+			 * @return the slot for the visitor type or nullptr if it hasn't been cached
+			 */
+			const Slot* find(const std::type_info* type) const noexcept {
+				const auto start = hash(type);
+				for (std::size_t i = 0; i < capacity; ++i) {
+					const auto& slot = slots[(start + i) & (capacity - 1)];
+					const auto* key = slot.visitorType.load(std::memory_order_acquire);
+					if (key == type)
+						return &slot;
+					else if (!key)
+						return nullptr;
+				}
+				return nullptr;
+			}
+			/**
+			 * Caches the visit of the visitor type. Does nothing if the cache is full
+			 */
+			void insert(const std::type_info* type, std::ptrdiff_t offset, CachedVisit visit) {
+				std::lock_guard<std::mutex> lk(insertLock);
+				const auto start = hash(type);
+				for (std::size_t i = 0; i < capacity; ++i) {
+					auto& slot = slots[(start + i) & (capacity - 1)];
+					const auto* key = slot.visitorType.load(std::memory_order_relaxed);
+					if (key == type)
+						return; // another thread got here first
+					else if (!key) {
+						slot.offset = offset;
+						slot.visit = visit;
+						slot.visitorType.store(type, std::memory_order_release);
+						return;
+					}
+				}
+			}
+		};
+	}
+
+	/**
+	 * Merges the counters of all threads
+	 * @return the combined hit and miss counts of all dispatch caches
+	 */
+	inline DispatchCacheStats dispatchCacheStats() {
+		return DispatchCacheTracker::registry().merge();
+	}
+
+	/**
+	 * Starts counting from zero, visits counted by other threads while it runs count either before or after it
+	 */
+	inline void resetDispatchCacheStats() {
+		DispatchCacheTracker::registry().reset();
+	}
+
+	/**
+	 * Memoizes the result of DynamicCastDispatchPolicy for each (dynamic visitor type, visited type) pair
+	 * After the first visit of a pair, the most derived visitor is adjusted by the cached offset without a dynamic_cast,
+	 * so that the offset is right whichever BaseVisitor subobject of the visitor is passed
+	 * Visitors that cannot visit the type are cached as well, and go through the dispatch table
+	 * @param <capacity> max amount of visitor types cached per visited type, must be a power of 2
+	 */
+	template<std::size_t capacity = 64>
+		requires (capacity > 0 && (capacity & (capacity - 1)) == 0)
+	struct CachedDispatchPolicy {
+		template<typename ReturnType, template<typename> typename up, typename T>
+		static ReturnType dispatch(T& visited, BaseVisitor& base) {
+			using namespace DispatchCacheTracker;
+			static DispatchCache<capacity> cache;
+			const auto* type = &typeid(base);
+			auto* const visitor = static_cast<char*>(dynamic_cast<void*>(&base));
+			if (const auto* slot = cache.find(type)) {
+				ThreadCounters::bump(ThreadCounters::current().hits);
+				switch (slot->visit) {
+				case CachedVisit::exact:
+					return reinterpret_cast<VisitorSingle<T, ReturnType>*>(visitor + slot->offset)
+						->visit(visited);
+				case CachedVisit::constant:
+					return reinterpret_cast<VisitorSingle<std::add_const_t<T>, ReturnType>*>(
+						visitor + slot->offset)->visit(visited);
+				default:
+					return VisitorDispatchTracker::visitFromTable<ReturnType, up>(visited, base);
+				}
+			}
+			ThreadCounters::bump(ThreadCounters::current().misses);
+			if (auto* v =
+				dynamic_cast<VisitorSingle<T, ReturnType>*>(&base)) {
+				cache.insert(type, reinterpret_cast<char*>(v) - visitor, CachedVisit::exact);
+				return v->visit(visited);
+			}
+			else if (auto* v =
+				dynamic_cast<VisitorSingle<std::add_const_t<T>, ReturnType>*>(&base)) {
+				cache.insert(type, reinterpret_cast<char*>(v) - visitor, CachedVisit::constant);
+				return v->visit(visited);
+			}
+			cache.insert(type, 0, CachedVisit::unknown);
+			return VisitorDispatchTracker::visitFromTable<ReturnType, up>(visited, base);
+		}
+	};
+#endif
+
 	/**
 	 * The visitable class can only accept mutable visitors and cannot be declared const
 	 */
@@ -76,34 +609,40 @@ namespace SUtil {
 	 * @param <ReturnType> the return type of the accept function
 	 * @param <up> the Unknown visitor Policy that dictates what to do when a visitor visits an object it isn't supposed to
 	 * @param <accessPolicy> the mutability level of accepted visitors
+	 * @param <dispatchPolicy> how the visit function of the visitor is found
 	 */
 	template<typename ReturnType = void,
 		template<typename> typename up = ExceptionUnknownPolicy,
-		template<typename> typename accessPolicy = MutableAndConstVisitablePolicy
+		template<typename> typename accessPolicy = MutableAndConstVisitablePolicy,
+		typename dispatchPolicy = DefaultDispatchPolicy
 	>
-		requires UnknownVisitorPolicy<up, ReturnType>
+		requires UnknownVisitorPolicy<up, ReturnType> &&
+			VisitorDispatchPolicy<dispatchPolicy, ReturnType>
 	class BaseVisitable : public accessPolicy<ReturnType> {
 	public:
 		virtual ~BaseVisitable() = default;
+
+		/**
+		 * Overriden by MAKE_VISITABLE
+		 * @return the id of the most derived type that uses MAKE_VISITABLE or the null id if none do
+		 */
+		virtual TypeId dynamicTypeId() const noexcept {
+			return {};
+		}
 	protected:
 		template<typename T>
 		static ReturnType acceptImpl(T& visited, class BaseVisitor& base) {
-			if (auto* v =
-				dynamic_cast<VisitorSingle<T, ReturnType>*>(&base)) {
-				return v->visit(visited);
-			}
-			else if (auto* v =
-				dynamic_cast<VisitorSingle<std::add_const_t<T>, ReturnType>*>(&base)) {
-				// cast should work if the visitor is const but the visited is mutable
-				return v->visit(visited);
-			}
-			return up<ReturnType>::onUnknownVisitor();
+#if defined(SUTIL_PROFILE_VISITS) && SUTIL_PROFILE_VISITS
+			VisitProfilerTracker::ScopedVisit profile(base, typeId<T>());
+#endif
+			return dispatchPolicy::template dispatch<ReturnType, up>(visited, base);
 		}
 	};
 
 	template<typename ReturnType = void,
-		template <typename> typename up = ExceptionUnknownPolicy>
-	using ImmutableBaseVisitable = BaseVisitable<ReturnType, up, ConstVisitablePolicy>;
+		template <typename> typename up = ExceptionUnknownPolicy,
+		typename dispatchPolicy = DefaultDispatchPolicy>
+	using ImmutableBaseVisitable = BaseVisitable<ReturnType, up, ConstVisitablePolicy, dispatchPolicy>;
 #define MAKE_MUTABLE_VISITABLE(ReturnType) \
 	virtual ReturnType accept(BaseVisitor& visit) override \
 	{ return acceptImpl(*this, visit);}
@@ -111,8 +650,13 @@ namespace SUtil {
 #define MAKE_CONST_VISITABLE(ReturnType) \
 	virtual ReturnType accept(BaseVisitor& visit) const override \
 	{ return acceptImpl(*this, visit);}
+
+#define VISITABLE_TYPE_ID \
+	virtual ::SUtil::TypeId dynamicTypeId() const noexcept override \
+	{ return ::SUtil::typeId<std::remove_cvref_t<decltype(*this)>>();}
 }
 #define MAKE_VISITABLE(ReturnType) \
 	MAKE_CONST_VISITABLE(ReturnType) \
-	MAKE_MUTABLE_VISITABLE(ReturnType)
+	MAKE_MUTABLE_VISITABLE(ReturnType) \
+	VISITABLE_TYPE_ID
 #endif
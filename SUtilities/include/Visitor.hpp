@@ -1,16 +1,108 @@
 #pragma once
 #ifndef _VISITOR_H
 #define _VISITOR_H
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
 /**
  * Acyclic visitor
  * Usage:
  *	- Make your visitor class subtype Visitor<ReturnType, Ts...>
  *  - implement the necessary overrides for each type you wish to visit
+ * Table dispatch:
+ *	- every VisitorSingle<T, ReturnType> interface is given a dense integer id the first time it is used
+ *	- every Visitor<ReturnType, Ts...> owns a flat table of visit thunks indexed by that id
+ *	- ids are handed out at runtime, so adding a visitable type does not change existing visitors
+ *	- used by visitables with the TableDispatchPolicy (see Visitable.hpp)
+ * Compact visitors:
+ *	- CompactVisitor<ReturnType, Ts...> declares the same visit(T&) functions as Visitor<ReturnType, Ts...>
+ *		in a single inheritance chain, so it has one vptr whatever the amount of types
+ *	- it has no VisitorSingle bases, visitables find its visit functions through its dispatch table,
+ *		which every dispatch policy searches first for a CompactVisitor
+ *	- cannot be used with ClosedVisitable or PolyCollection
  */
 namespace SUtil {
+	class BaseVisitor;
+
+	/**
+	 * Not for external use
+	 */
+	namespace VisitorDispatchTracker {
+		/// type erased thunk, must be cast back to Thunk<ReturnType> before it is called
+		using ErasedThunk = void(*)();
+
+		template<typename ReturnType>
+		using Thunk = ReturnType(*)(BaseVisitor&, void*);
+
+		inline std::size_t nextDispatchId() noexcept {
+			static std::atomic<std::size_t> counter{ 0 };
+			return counter.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * Gets the dense id of the VisitorSingle<T, ReturnType> interface
+	 * T and const T are different interfaces and have different ids
+	 */
+	template<typename T, typename ReturnType>
+	std::size_t dispatchId() noexcept {
+		static const std::size_t id = VisitorDispatchTracker::nextDispatchId();
+		return id;
+	}
+
+	/**
+	 * Flat table of visit thunks indexed by dispatchId()
+	 */
+	class DispatchTable {
+	private:
+		std::vector<VisitorDispatchTracker::ErasedThunk> thunks;
+		bool onlyTable = false;
+	public:
+		DispatchTable() = default;
+		/**
+		 * @param onlyTable true if the visitor has no VisitorSingle bases, so visitables should search the table first
+		 */
+		explicit DispatchTable(bool onlyTable) noexcept : onlyTable(onlyTable) {}
+
+		bool tableOnly() const noexcept {
+			return onlyTable;
+		}
+
+		/**
+		 * @return the thunk for the interface with the specified id or nullptr if there is none
+		 */
+		template<typename ReturnType>
+		VisitorDispatchTracker::Thunk<ReturnType> find(std::size_t id) const noexcept {
+			if (id >= thunks.size() || !thunks[id])
+				return nullptr;
+			return reinterpret_cast<VisitorDispatchTracker::Thunk<ReturnType>>(thunks[id]);
+		}
+
+		template<typename ReturnType>
+		void insert(std::size_t id, VisitorDispatchTracker::Thunk<ReturnType> thunk) {
+			if (id >= thunks.size())
+				thunks.resize(id + 1, nullptr);
+			thunks[id] = reinterpret_cast<VisitorDispatchTracker::ErasedThunk>(thunk);
+		}
+	};
+
 	class BaseVisitor {
 	public:
+		BaseVisitor() = default;
 		virtual ~BaseVisitor() = default;
+
+		/**
+		 * @return the flat dispatch table of the visitor or nullptr if it only supports dynamic_cast dispatch
+		 */
+		const DispatchTable* dispatchTable() const noexcept {
+			return table;
+		}
+	protected:
+		explicit BaseVisitor(const DispatchTable* table) noexcept : table(table) {}
+	private:
+		const DispatchTable* table = nullptr;
 	};
 
 	template<typename T, typename ReturnType>
@@ -19,6 +111,45 @@ namespace SUtil {
 		virtual ReturnType visit(T&) = 0;
 	};
 
+	namespace VisitorDispatchTracker {
+		/**
+		 * @return the thunk for visit(T&) in the dispatch table of the visitor or nullptr if there is none
+		 */
+		template<typename T, typename ReturnType>
+		Thunk<ReturnType> findThunk(const BaseVisitor& visitor) noexcept {
+			const auto* table = visitor.dispatchTable();
+			return table ? table->template find<ReturnType>(dispatchId<T, ReturnType>()) : nullptr;
+		}
+
+		template<typename Caller, typename ReturnType, typename T>
+		ReturnType thunk(BaseVisitor& visitor, void* visited) {
+			return Caller::template call<T>(visitor, *static_cast<T*>(visited));
+		}
+
+		/**
+		 * Builds the dispatch table shared by all visitors of one class
+		 * @param <Caller> has a static function template call<T>(BaseVisitor&, T&) that calls visit(T&)
+		 * @param <tableOnly> true if the visitor has no VisitorSingle bases
+		 */
+		template<typename Caller, typename ReturnType, bool tableOnly, typename ... Ts>
+		const DispatchTable& tableOf() {
+			static const DispatchTable dispatch = [] {
+				DispatchTable result(tableOnly);
+				// a const visit can also visit a mutable object
+				// inserted before the exact thunks so that a mutable overload takes priority
+				([&result] {
+					if constexpr (std::is_const_v<Ts>) {
+						result.insert<ReturnType>(dispatchId<std::remove_const_t<Ts>, ReturnType>(),
+							&thunk<Caller, ReturnType, Ts>);
+					}
+				}(), ...);
+				(result.insert<ReturnType>(dispatchId<Ts, ReturnType>(), &thunk<Caller, ReturnType, Ts>), ...);
+				return result;
+			}();
+			return dispatch;
+		}
+	}
+
 	/**
 	 * Base class for visitors
 	 * @param <ReturnType> the return type of the visit() function
@@ -26,9 +157,102 @@ namespace SUtil {
 	 */
 	template<typename ReturnType, typename ... Ts>
 	class Visitor : public BaseVisitor, public VisitorSingle<Ts, ReturnType>... {
+	public:
+		Visitor() : BaseVisitor(&VisitorDispatchTracker::tableOf<Caller, ReturnType, false, Ts...>()) {}
+	private:
+		struct Caller {
+			template<typename T>
+			static ReturnType call(BaseVisitor& visitor, T& visited) {
+				return static_cast<VisitorSingle<T, ReturnType>&>(static_cast<Visitor&>(visitor)).visit(visited);
+			}
+		};
 	};
 
 	template<typename ... Ts>
 	using Visitor_v = Visitor<void, Ts...>;
+
+	namespace VisitorDispatchTracker {
+		template<typename ReturnType, typename ... Ts>
+		class CompactChain;
+
+		template<typename ReturnType, typename T>
+		class CompactChain<ReturnType, T> : public BaseVisitor {
+		public:
+			virtual ReturnType visit(T&) = 0;
+		protected:
+			using BaseVisitor::BaseVisitor;
+		};
+
+		/**
+		 * One link of the single inheritance chain of a CompactVisitor, declares visit(T&)
+		 */
+		template<typename ReturnType, typename T, typename U, typename ... Ts>
+		class CompactChain<ReturnType, T, U, Ts...> : public CompactChain<ReturnType, U, Ts...> {
+		public:
+			using CompactChain<ReturnType, U, Ts...>::visit;
+			virtual ReturnType visit(T&) = 0;
+		protected:
+			using CompactChain<ReturnType, U, Ts...>::CompactChain;
+		};
+	}
+
+	/**
+	 * Base class for visitors with a single vptr, a drop in replacement for Visitor<ReturnType, Ts...>
+	 * Smaller and cheaper to copy than Visitor when there are many types, but visitables must find the
+	 * visit function through the dispatch table
+	 * @param <ReturnType> the return type of the visit() function
+	 * @param <Ts> the types that you would like to be able to visit
+	 */
+	template<typename ReturnType, typename ... Ts>
+	class CompactVisitor : public VisitorDispatchTracker::CompactChain<ReturnType, Ts...> {
+	public:
+		CompactVisitor() : VisitorDispatchTracker::CompactChain<ReturnType, Ts...>(
+			&VisitorDispatchTracker::tableOf<Caller, ReturnType, true, Ts...>()) {}
+		using VisitorDispatchTracker::CompactChain<ReturnType, Ts...>::visit;
+	private:
+		struct Caller {
+			/// overload resolution picks visit(T&), T& is an exact match for exactly one of the overloads
+			template<typename T>
+			static ReturnType call(BaseVisitor& visitor, T& visited) {
+				return static_cast<CompactVisitor&>(visitor).visit(visited);
+			}
+		};
+	};
+
+	template<typename ... Ts>
+	using CompactVisitor_v = CompactVisitor<void, Ts...>;
+
+	namespace VisitorDispatchTracker {
+		template<typename ReturnType, typename ... Ts>
+		Visitor<ReturnType, Ts...>* baseOf(const Visitor<ReturnType, Ts...>&);
+
+		template<typename ReturnType, typename ... Ts>
+		CompactVisitor<ReturnType, Ts...>* baseOf(const CompactVisitor<ReturnType, Ts...>&);
+
+		template<typename ReturnType, typename ... Ts>
+		ReturnType returnTypeOf(const Visitor<ReturnType, Ts...>&);
+
+		template<typename ReturnType, typename ... Ts>
+		ReturnType returnTypeOf(const CompactVisitor<ReturnType, Ts...>&);
+	}
+
+	/**
+	 * Gets the Visitor<ReturnType, Ts...> or CompactVisitor<ReturnType, Ts...> that V subtypes
+	 */
+	template<typename V>
+	using visitor_base_t = std::remove_pointer_t<decltype(VisitorDispatchTracker::baseOf(std::declval<V&>()))>;
+
+	/**
+	 * A subtype of Visitor<ReturnType, Ts...> or CompactVisitor<ReturnType, Ts...>
+	 */
+	template<typename V>
+	concept TypedVisitor = requires { typename visitor_base_t<V>; };
+
+	/**
+	 * Gets the return type of the visit functions of a subtype of Visitor<ReturnType, Ts...>
+	 * or CompactVisitor<ReturnType, Ts...>
+	 */
+	template<typename V>
+	using visitor_return_t = decltype(VisitorDispatchTracker::returnTypeOf(std::declval<V&>()));
 }
 #endif
@@ -0,0 +1,537 @@
+#pragma once
+#ifndef _VISITOR_ALGORITHMS_H
+#define _VISITOR_ALGORITHMS_H
+#include "TypeId.hpp"
+#include "Visitable.hpp"
+#include "Visitor.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+/**
+ * Algorithms for visiting many visitables at once
+ *	- acceptAll: visits a range of pointers to visitables, resolving the visit function once per dynamic type
+ *		instead of once per element
+ *	- parallelAcceptAll: visits a range of pointers to visitables on several threads, each with its own
+ *		copy of the visitor. Chunks of the range are balanced between the threads with work stealing
+ *	- tryAcceptAll: acceptAll for visitors returning VisitResult<>, counts the failed visits instead of stopping
+ *		at the first one. Pair it with visitables using ExpectedUnknownPolicy
+ * VisitOrder:
+ *	- preserved (default): elements are visited in the order of the range
+ *	- grouped: elements are partitioned by dynamic type and each run of same typed elements is visited
+ *		in a tight loop. Elements of one type are visited in their original relative order.
+ *		Partitioning reads every element twice, so it only pays off when visits of one type benefit
+ *		from running together. To store elements grouped by type in the first place, use a PolyCollection
+ * The lookup of the visit function is what is saved, so it is faster than accept() for visitables with the
+ * DynamicCastDispatchPolicy, but not for the TableDispatchPolicy whose accept() is already a table lookup
+ * Elements are grouped by dynamicTypeId(), so a type that inherits MAKE_VISITABLE from its parent
+ * is visited as its parent. Elements with a null id are visited with accept(). As with accept(),
+ * elements that only accept const visitors are only visited by visit(const T&). Does not use RTTI
+ */
+namespace SUtil {
+	enum class VisitOrder {
+		grouped,
+		preserved
+	};
+
+	/**
+	 * Visit counts of tryAcceptAll
+	 */
+	struct BatchVisitStats {
+		std::size_t handled;
+		std::size_t unhandled;
+	};
+
+	template<typename Acc>
+	struct BatchVisitResult {
+		Acc value;
+		BatchVisitStats stats;
+	};
+
+	/**
+	 * Not for external use
+	 */
+	namespace VisitorAlgorithmsTracker {
+		/// Discards the result of every visit
+		struct NoReduction {
+			template<typename T>
+			void add(T&&) noexcept {}
+		};
+
+		template<typename Acc, typename Reduce>
+		struct Reduction {
+			Acc acc;
+			Reduce& reduce;
+
+			template<typename T>
+			void add(T&& result) {
+				acc = reduce(std::move(acc), std::forward<T>(result));
+			}
+		};
+
+		/**
+		 * Counts failed visits and passes the results of successful ones on to the inner state
+		 */
+		template<typename Inner>
+		struct CountingReduction {
+			Inner inner;
+			BatchVisitStats stats{ 0, 0 };
+
+			template<typename T>
+			void add(T&& result) {
+				if (result) [[likely]] {
+					++stats.handled;
+					if constexpr (!std::is_void_v<typename std::remove_cvref_t<T>::value_type>)
+						inner.add(*std::forward<T>(result));
+				}
+				else
+					++stats.unhandled;
+			}
+		};
+
+		template<typename ReturnType>
+		std::true_type onlyConstAccept(const volatile ConstVisitablePolicy<ReturnType>*);
+		std::false_type onlyConstAccept(const volatile void*);
+
+		/**
+		 * True if the elements can only be visited by visit(const T&), as with accept()
+		 * because they are const or only accept const visitors
+		 */
+		template<typename Element>
+		constexpr bool constElements = std::is_const_v<Element> ||
+			decltype(onlyConstAccept(std::declval<Element*>()))::value;
+
+		/**
+		 * Visits a run of elements that all have the same dynamic type
+		 * @param <Element> the visitable type pointed to by the elements of the range, possibly const
+		 * @param <VisitorBase> Visitor<ReturnType, Ts...> or CompactVisitor<ReturnType, Ts...>
+		 */
+		template<typename Element, typename VisitorBase, typename ReturnType, typename State, typename ... Ts>
+		struct Runs {
+			using Run = void(*)(VisitorBase&, Element* const*, Element* const*, State&);
+
+			/**
+			 * @param <T> the visited type, the dynamic type of all elements in the run
+			 */
+			template<typename T>
+			static void visitRun(VisitorBase& visitor, Element* const* begin, Element* const* end,
+				State& state) {
+				// a CompactVisitor has no VisitorSingle bases, but its visit(T&) is picked by overload resolution
+				auto& single = [&visitor]() -> auto& {
+					if constexpr (std::is_base_of_v<VisitorSingle<T, ReturnType>, VisitorBase>)
+						return static_cast<VisitorSingle<T, ReturnType>&>(visitor);
+					else
+						return visitor;
+				}();
+				for (; begin != end; ++begin) {
+					if constexpr (std::is_void_v<ReturnType>)
+						single.visit(static_cast<T&>(**begin));
+					else
+						state.add(single.visit(static_cast<T&>(**begin)));
+				}
+			}
+
+			/**
+			 * Used for types that aren't one of Ts, lets the element decide with accept()
+			 */
+			static void acceptRun(VisitorBase& visitor, Element* const* begin, Element* const* end,
+				State& state) {
+				for (; begin != end; ++begin) {
+					if constexpr (std::is_void_v<ReturnType>)
+						(*begin)->accept(visitor);
+					else
+						state.add((*begin)->accept(visitor));
+				}
+			}
+
+			template<typename T>
+			static Run runFor(TypeId type, bool constVisit) {
+				using Visited = std::remove_const_t<T>;
+				// a const element can only be visited by visit(const T&)
+				if constexpr (std::is_base_of_v<std::remove_const_t<Element>, Visited> &&
+					(std::is_const_v<T> || !constElements<Element>)) {
+					if (std::is_const_v<T> == constVisit && typeId<Visited>() == type)
+						return &visitRun<T>;
+				}
+				return nullptr;
+			}
+
+			/**
+			 * Gets the run function for the dynamic type, prefering visit(T&) over visit(const T&)
+			 */
+			static Run resolve(TypeId type) {
+				Run run = nullptr;
+				if constexpr (!constElements<Element>) {
+					((run = run ? run : runFor<Ts>(type, false)), ...);
+				}
+				((run = run ? run : runFor<Ts>(type, true)), ...);
+				return run ? run : &acceptRun;
+			}
+		};
+
+		template<typename Run>
+		struct TypeGroup {
+			TypeId type;
+			Run run;
+			std::size_t count;
+			std::size_t offset;
+		};
+
+		/**
+		 * Direct mapped cache of the group of each type, so that finding the group of an element
+		 * doesn't depend on the type of the previous one
+		 */
+		class GroupCache {
+		private:
+			static constexpr std::size_t size = 16;
+			static constexpr auto npos = std::numeric_limits<std::uint32_t>::max();
+			struct Entry {
+				TypeId type;
+				std::uint32_t group = npos;
+			};
+			std::array<Entry, size> entries{};
+		public:
+			/**
+			 * @return the group of the type or nothing if it isn't cached
+			 */
+			std::optional<std::uint32_t> find(TypeId type) const noexcept {
+				const auto& entry = entries[type.hash() % size];
+				if (entry.group != npos && entry.type == type) [[likely]]
+					return entry.group;
+				return std::nullopt;
+			}
+			void insert(TypeId type, std::uint32_t group) noexcept {
+				entries[type.hash() % size] = { type, group };
+			}
+		};
+
+		/**
+		 * Finds the group of the type, adding a new group if there is none
+		 */
+		template<typename Runs>
+		std::uint32_t groupOf(std::vector<TypeGroup<typename Runs::Run>>& groups, GroupCache& cache, TypeId type) {
+			if (auto cached = cache.find(type))
+				return *cached;
+			std::uint32_t group = 0;
+			while (group < groups.size() && groups[group].type != type)
+				++group;
+			if (group == groups.size())
+				groups.push_back({ type, Runs::resolve(type), 0, 0 });
+			cache.insert(type, group);
+			return group;
+		}
+
+		template<typename Range>
+		using element_t = std::remove_reference_t<decltype(*std::declval<std::ranges::range_reference_t<Range>>())>;
+
+		template<typename Range>
+		auto gatherElements(Range&& range) {
+			std::vector<element_t<Range>*> elements;
+			if constexpr (std::ranges::sized_range<Range>)
+				elements.reserve(std::ranges::size(range));
+			for (auto&& element : range)
+				elements.push_back(std::addressof(*element));
+			return elements;
+		}
+
+		template<typename Range, template<typename, typename...> typename VisitorBase, typename ReturnType,
+			typename State, typename ... Ts>
+		void acceptAll(Range&& range, VisitorBase<ReturnType, Ts...>& visitor, State& state, VisitOrder order) {
+			using Element = element_t<Range>;
+			using R = Runs<Element, VisitorBase<ReturnType, Ts...>, ReturnType, State, Ts...>;
+			std::vector<TypeGroup<typename R::Run>> groups;
+			GroupCache cache;
+			if (order == VisitOrder::preserved) {
+				// nothing to reorder, so the range is visited in place
+				for (auto&& element : range) {
+					Element* visited = std::addressof(*element);
+					const auto group = groupOf<R>(groups, cache, visited->dynamicTypeId());
+					groups[group].run(visitor, &visited, &visited + 1, state);
+				}
+				return;
+			}
+
+			auto elements = gatherElements(std::forward<Range>(range));
+			std::vector<std::uint32_t> keys(elements.size());
+			for (std::size_t i = 0; i < elements.size(); ++i) {
+				keys[i] = groupOf<R>(groups, cache, elements[i]->dynamicTypeId());
+				++groups[keys[i]].count;
+			}
+			std::size_t offset = 0;
+			for (auto& group : groups) {
+				group.offset = offset;
+				offset += group.count;
+			}
+			// stable counting sort by group
+			std::vector<Element*> sorted(elements.size());
+			for (std::size_t i = 0; i < elements.size(); ++i) {
+				sorted[groups[keys[i]].offset++] = elements[i];
+			}
+			auto* begin = sorted.data();
+			for (const auto& group : groups) {
+				group.run(visitor, begin, begin + group.count, state);
+				begin += group.count;
+			}
+		}
+	}
+
+	struct ParallelOptions {
+		/// amount of threads visiting, including the calling thread
+		unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+		/// amount of elements visited at once, the unit of work that can be stolen
+		std::size_t chunkSize = 1024;
+	};
+
+	namespace VisitorAlgorithmsTracker {
+		/**
+		 * The chunks [next, end) a worker has left, packed into one word so that the owner taking
+		 * a chunk from the front and thieves taking half from the back are both a single CAS
+		 * Each range has its own cache line, so that owners popping chunks don't contend with each other
+		 */
+		class alignas(64) ChunkRange {
+		private:
+			std::atomic<std::uint64_t> range{ 0 };
+
+			static constexpr std::uint64_t pack(std::uint32_t next, std::uint32_t end) noexcept {
+				return (static_cast<std::uint64_t>(next) << 32) | end;
+			}
+		public:
+			/**
+			 * Only called by the owner when its range is empty, a thief never changes an empty range
+			 */
+			void reset(std::uint32_t next, std::uint32_t end) noexcept {
+				range.store(pack(next, end), std::memory_order_release);
+			}
+
+			/**
+			 * Called by the owner
+			 * @return the next chunk or nothing if the range is empty
+			 */
+			std::optional<std::uint32_t> pop() noexcept {
+				auto current = range.load(std::memory_order_acquire);
+				for (;;) {
+					const auto next = static_cast<std::uint32_t>(current >> 32);
+					const auto end = static_cast<std::uint32_t>(current);
+					if (next >= end)
+						return std::nullopt;
+					if (range.compare_exchange_weak(current, pack(next + 1, end), std::memory_order_acq_rel))
+						return next;
+				}
+			}
+
+			/**
+			 * Called by other workers
+			 * @return the stolen back half of the range as (next, end) or nothing if the range is empty
+			 */
+			std::optional<std::pair<std::uint32_t, std::uint32_t>> steal() noexcept {
+				auto current = range.load(std::memory_order_acquire);
+				for (;;) {
+					const auto next = static_cast<std::uint32_t>(current >> 32);
+					const auto end = static_cast<std::uint32_t>(current);
+					if (next >= end)
+						return std::nullopt;
+					const auto half = (end - next + 1) / 2;
+					if (range.compare_exchange_weak(current, pack(next, end - half), std::memory_order_acq_rel))
+						return std::pair{ end - half, end };
+				}
+			}
+		};
+
+		/**
+		 * Visits the elements on options.threads threads, each worker owning a copy of the visitor
+		 * and a partial result. The calling thread is worker 0
+		 * @param visitChunk callable with the signature void(V& visitor, State& partial, std::size_t begin, std::size_t end)
+		 */
+		template<typename V, typename State, typename VisitChunk>
+		std::vector<State> parallelVisit(const V& visitor, const State& initial, std::size_t size,
+			ParallelOptions options, VisitChunk&& visitChunk) {
+			const auto chunkSize = std::max<std::size_t>(1, options.chunkSize);
+			const auto chunks = static_cast<std::uint32_t>((size + chunkSize - 1) / chunkSize);
+			const auto threads = std::max(1u, std::min<unsigned>(options.threads, std::max(1u, chunks)));
+			std::vector<ChunkRange> ranges(threads);
+			for (unsigned i = 0; i < threads; ++i) {
+				ranges[i].reset(static_cast<std::uint32_t>(static_cast<std::uint64_t>(chunks) * i / threads),
+					static_cast<std::uint32_t>(static_cast<std::uint64_t>(chunks) * (i + 1) / threads));
+			}
+			// emplaced by each worker that finishes, so State only has to be copy constructible
+			std::vector<std::optional<State>> partials(threads);
+			std::atomic<bool> failed = false;
+			std::exception_ptr error;
+			std::mutex errorLock;
+
+			auto work = [&](unsigned self) {
+				try {
+					V clone(visitor);
+					// accumulated on the stack of the worker, partials are next to each other and would share cache lines
+					State partial(initial);
+					for (;;) {
+						while (auto chunk = ranges[self].pop()) {
+							if (failed.load(std::memory_order_relaxed))
+								return;
+							const auto begin = *chunk * chunkSize;
+							visitChunk(clone, partial, begin, std::min(size, begin + chunkSize));
+						}
+						std::optional<std::pair<std::uint32_t, std::uint32_t>> stolen;
+						for (unsigned i = 1; i < threads && !stolen; ++i) {
+							stolen = ranges[(self + i) % threads].steal();
+						}
+						if (!stolen)
+							break;
+						ranges[self].reset(stolen->first, stolen->second);
+					}
+					partials[self].emplace(std::move(partial));
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> lk(errorLock);
+					if (!error)
+						error = std::current_exception();
+					failed.store(true, std::memory_order_relaxed);
+				}
+			};
+			{
+				std::vector<std::jthread> workers;
+				workers.reserve(threads - 1);
+				for (unsigned i = 1; i < threads; ++i) {
+					workers.emplace_back(work, i);
+				}
+				work(0);
+			}
+			if (error)
+				std::rethrow_exception(error);
+			std::vector<State> result;
+			result.reserve(threads);
+			for (auto& partial : partials) {
+				result.push_back(std::move(*partial));
+			}
+			return result;
+		}
+	}
+
+	/**
+	 * Visits every element of a range of pointers (raw or smart) to visitables
+	 * The visit function is resolved once per dynamic type, results of non void visits are discarded
+	 * Elements whose dynamic type is not one of Ts are visited with their accept() function
+	 * @param visitor a subtype of Visitor<ReturnType, Ts...> or CompactVisitor<ReturnType, Ts...>
+	 * @param order VisitOrder::grouped to visit the elements type by type
+	 */
+	template<std::ranges::input_range Range, TypedVisitor V>
+	void acceptAll(Range&& range, V& visitor, VisitOrder order = VisitOrder::preserved) {
+		VisitorAlgorithmsTracker::NoReduction state;
+		VisitorAlgorithmsTracker::acceptAll(std::forward<Range>(range), static_cast<visitor_base_t<V>&>(visitor),
+			state, order);
+	}
+
+	/**
+	 * Visits every element of a range of pointers to visitables and combines the results
+	 * In grouped order, results are reduced in group order, so reduce should then be associative and commutative
+	 * @param init the initial value of the reduction
+	 * @param reduce callable with the signature Acc(Acc, ReturnType)
+	 * @return the reduction of init and all visit results
+	 */
+	template<std::ranges::input_range Range, TypedVisitor V, typename Acc, typename Reduce>
+		requires (!std::is_void_v<visitor_return_t<V>> && std::is_invocable_r_v<Acc, Reduce&, Acc, visitor_return_t<V>>)
+	Acc acceptAll(Range&& range, V& visitor, Acc init, Reduce reduce, VisitOrder order = VisitOrder::preserved) {
+		VisitorAlgorithmsTracker::Reduction<Acc, Reduce> state{ std::move(init), reduce };
+		VisitorAlgorithmsTracker::acceptAll(std::forward<Range>(range), static_cast<visitor_base_t<V>&>(visitor),
+			state, order);
+		return std::move(state.acc);
+	}
+
+	/**
+	 * Visits every element of a range of pointers to visitables, counting the visits that failed
+	 * Unlike an exception, a failed visit does not stop the remaining elements from being visited
+	 * @param visitor a subtype of Visitor<VisitResult<R>, Ts...> or CompactVisitor<VisitResult<R>, Ts...>
+	 */
+	template<std::ranges::input_range Range, TypedVisitor V>
+		requires is_visit_result_v<visitor_return_t<V>>
+	BatchVisitStats tryAcceptAll(Range&& range, V& visitor, VisitOrder order = VisitOrder::preserved) {
+		VisitorAlgorithmsTracker::CountingReduction<VisitorAlgorithmsTracker::NoReduction> state;
+		VisitorAlgorithmsTracker::acceptAll(std::forward<Range>(range), static_cast<visitor_base_t<V>&>(visitor),
+			state, order);
+		return state.stats;
+	}
+
+	/**
+	 * Visits every element of a range of pointers to visitables, combining the results of the successful visits
+	 * and counting the failed ones
+	 * @param reduce callable with the signature Acc(Acc, R) where the visitor returns VisitResult<R>
+	 */
+	template<std::ranges::input_range Range, TypedVisitor V, typename Acc, typename Reduce>
+		requires is_visit_result_v<visitor_return_t<V>> &&
+			(!std::is_void_v<typename visitor_return_t<V>::value_type>) &&
+			std::is_invocable_r_v<Acc, Reduce&, Acc, typename visitor_return_t<V>::value_type>
+	BatchVisitResult<Acc> tryAcceptAll(Range&& range, V& visitor, Acc init, Reduce reduce,
+		VisitOrder order = VisitOrder::preserved) {
+		VisitorAlgorithmsTracker::CountingReduction<VisitorAlgorithmsTracker::Reduction<Acc, Reduce>> state{
+			{ std::move(init), reduce } };
+		VisitorAlgorithmsTracker::acceptAll(std::forward<Range>(range), static_cast<visitor_base_t<V>&>(visitor),
+			state, order);
+		return { std::move(state.inner.acc), state.stats };
+	}
+
+	/**
+	 * Visits every element of a range of pointers to visitables on several threads
+	 * Each thread visits with its own copy of the visitor, so visit functions must be independent of each other
+	 * If a visit throws, the remaining chunks are skipped and the first exception is rethrown
+	 * @param visitor the visitor to copy, must be copy constructible
+	 */
+	template<std::ranges::input_range Range, typename V>
+		requires std::derived_from<V, BaseVisitor> && std::copy_constructible<V>
+	void parallelAcceptAll(Range&& range, const V& visitor, ParallelOptions options = {}) {
+		const auto elements = VisitorAlgorithmsTracker::gatherElements(std::forward<Range>(range));
+		VisitorAlgorithmsTracker::parallelVisit(visitor, 0, elements.size(), options,
+			[&elements](V& clone, int&, std::size_t begin, std::size_t end) {
+				for (; begin != end; ++begin) {
+					elements[begin]->accept(clone);
+				}
+			});
+	}
+
+	/**
+	 * Visits every element of a range of pointers to visitables on several threads and combines the results
+	 * Each thread reduces its results into a partial result starting from identity, the partial results
+	 * are then reduced in an unspecified order, so reduce must be associative and commutative
+	 * @param identity the identity value of reduce
+	 * @param reduce callable with the signatures Acc(Acc, ReturnType) and Acc(Acc, Acc). Each thread
+	 * reduces with its own copy, so a stateful reduce is not shared between threads
+	 * @return the reduction of all visit results
+	 */
+	template<std::ranges::input_range Range, typename V, typename Acc, typename Reduce>
+		requires std::derived_from<V, BaseVisitor> && std::copy_constructible<V> &&
+			std::copy_constructible<Reduce> && (!std::is_void_v<visitor_return_t<V>>) &&
+			std::is_invocable_r_v<Acc, Reduce&, Acc, visitor_return_t<V>> &&
+			std::is_invocable_r_v<Acc, Reduce&, Acc, Acc>
+	Acc parallelAcceptAll(Range&& range, const V& visitor, Acc identity, Reduce reduce, ParallelOptions options = {}) {
+		/// the partial result of a thread and the copy of reduce it is reduced with
+		struct Partial {
+			Acc acc;
+			Reduce reduce;
+		};
+		const auto elements = VisitorAlgorithmsTracker::gatherElements(std::forward<Range>(range));
+		auto partials = VisitorAlgorithmsTracker::parallelVisit(visitor, Partial{ std::move(identity), reduce },
+			elements.size(), options, [&elements](V& clone, Partial& partial, std::size_t begin, std::size_t end) {
+				for (; begin != end; ++begin) {
+					partial.acc = partial.reduce(std::move(partial.acc), elements[begin]->accept(clone));
+				}
+			});
+		// parallelVisit always returns at least one partial result
+		Acc result = std::move(partials.front().acc);
+		for (auto it = std::next(partials.begin()); it != partials.end(); ++it) {
+			result = reduce(std::move(result), std::move(it->acc));
+		}
+		return result;
+	}
+}
+#endif
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include <Visitable.hpp>
+#include <Visitor.hpp>
+#include <VisitorAlgorithms.hpp>
+#include <MultiVisitor.hpp>
+#include <TypeList.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Built with RTTI disabled, everything here must work without typeid and dynamic_cast
+static_assert(!SUTIL_RTTI);
+
+using namespace SUtil;
+
+namespace {
+	struct Leaf : public BaseVisitable<int> {
+		int value = 1;
+		MAKE_VISITABLE(int);
+	};
+	struct Branch : public BaseVisitable<int> {
+		int value = 2;
+		MAKE_VISITABLE(int);
+	};
+	struct Unvisited : public BaseVisitable<int> {
+		MAKE_VISITABLE(int);
+	};
+	/// inherits the visitable id of Leaf
+	struct SmallLeaf : public Leaf {};
+
+	class SumVisitor : public Visitor<int, Leaf, const Branch> {
+	public:
+		int visit(Leaf& l) override { return l.value; }
+		int visit(const Branch& b) override { return b.value * 10; }
+	};
+}
+
+TEST(NoRttiTest, typeIdTest) {
+	static_assert(typeId<int>() == typeId<const int>());
+	static_assert(typeId<Leaf>() != typeId<Branch>());
+	static_assert(TL::getId<TL::TypeList<Leaf, Branch>>(1) == typeId<Branch>());
+	Leaf leaf;
+	SmallLeaf small;
+	const BaseVisitable<int>& unknown = small;
+	ASSERT_EQ(leaf.dynamicTypeId(), typeId<Leaf>());
+	ASSERT_EQ(unknown.dynamicTypeId(), typeId<Leaf>());
+	std::vector<TypeId> ids;
+	TL::for_each<TL::TypeList<Leaf, Branch>>([&ids](TypeId id) {
+		ids.push_back(id);
+	});
+	ASSERT_EQ(ids, (std::vector{ typeId<Leaf>(), typeId<Branch>() }));
+}
+
+TEST(NoRttiTest, visitorTest) {
+	static_assert(std::is_same_v<DefaultDispatchPolicy, TableDispatchPolicy>);
+	Leaf leaf;
+	Branch branch;
+	const Branch cBranch;
+	Unvisited unvisited;
+	SumVisitor visitor;
+	ASSERT_EQ(leaf.accept(visitor), 1);
+	ASSERT_EQ(branch.accept(visitor), 20);
+	ASSERT_EQ(cBranch.accept(visitor), 20);
+	ASSERT_THROW(unvisited.accept(visitor), UnknownVisitorException);
+
+	SmallLeaf small;
+	std::vector<BaseVisitable<int>*> nodes = { &leaf, &branch, &small, &branch };
+	ASSERT_EQ(acceptAll(nodes, visitor, 0, std::plus<int>{}), 42);
+	ASSERT_EQ(acceptAll(nodes, visitor, 0, std::plus<int>{}, VisitOrder::preserved), 42);
+	nodes.push_back(&unvisited);
+	ASSERT_THROW(acceptAll(nodes, visitor), UnknownVisitorException);
+}
+
+TEST(NoRttiTest, multiVisitorTest) {
+	struct Collide {
+		std::string visit(Leaf&, Branch&) { return "leaf branch"; }
+		std::string visit(Leaf&, Leaf&) { return "leaf leaf"; }
+	};
+	using Nodes = TL::TypeList<Leaf, Branch>;
+	using Symmetric = MultiVisitor<std::string, Nodes, Nodes, MultiDispatch::symmetric>;
+	Leaf leaf;
+	Branch branch;
+	Unvisited unvisited;
+	BaseVisitable<int>& l = leaf;
+	BaseVisitable<int>& b = branch;
+	BaseVisitable<int>& u = unvisited;
+	Collide collide;
+	ASSERT_EQ(Symmetric::dispatch(collide, l, b), "leaf branch");
+	ASSERT_EQ(Symmetric::dispatch(collide, b, l), "leaf branch");
+	ASSERT_EQ(Symmetric::dispatch(collide, l, l), "leaf leaf");
+	ASSERT_THROW(Symmetric::dispatch(collide, b, b), UnknownVisitorException);
+	ASSERT_THROW(Symmetric::dispatch(collide, l, u), UnknownVisitorException);
+}
+
+int main(int argc, char** argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -1,5 +1,16 @@
 #include <stdio.h>
 #include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include <gtest/gtest.h>
 struct DeinitChecker {
 	inline static std::vector<unsigned> order;
@@ -19,6 +30,10 @@ struct DeinitChecker {
 };
 static DeinitChecker lifetimeChecker;
 #include <Singleton.hpp>
+#include <SingletonRegistry.hpp>
+#include <SwappableSingleton.hpp>
+#include <SingletonTelemetry.hpp>
+#include <SingletonFamily.hpp>
 
 using namespace SUtil;
 std::stringstream ss;
@@ -48,6 +63,12 @@ TEST(SingletonTest, basicTest) {
 	user.~SingletonUser();
 	ASSERT_EQ(ss.str(), "Hello there\nGoodbye\n");
 }
+/**
+ * A distinct type for each tag, so that each test gets its own singleton
+ */
+template<typename T, int tag>
+struct Tagged : T {};
+
 template<unsigned i>
 struct S {
 	S() {
@@ -79,6 +100,499 @@ TEST(SingletonTest, longevityTest) {
 	single5000.get();
 }
 
+template<int tag>
+struct Counted {
+	inline static std::atomic<int> constructed{ 0 };
+	Counted() {
+		++constructed;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+};
+
+template<typename Single, typename T>
+void expectSingleConstruction() {
+	Single handle;
+	std::vector<std::thread> threads;
+	std::atomic<T*> first{ nullptr };
+	std::atomic<bool> same{ true };
+	for (int i = 0; i < 8; ++i) {
+		threads.emplace_back([&]() {
+			T* obj = &Single::get();
+			T* expected = nullptr;
+			if (!first.compare_exchange_strong(expected, obj) && expected != obj)
+				same = false;
+		});
+	}
+	for (auto& t : threads)
+		t.join();
+	ASSERT_TRUE(same);
+	ASSERT_EQ(T::constructed, 1);
+	ASSERT_EQ(&Single::get(), first.load());
+}
+
+TEST(SingletonTest, concurrentGetTest) {
+	expectSingleConstruction<MTSingleton_t<Counted<0>>, Counted<0>>();
+	expectSingleConstruction<Singleton<Counted<1>, ErrorDeadRefPolicy, FreeStoreCreatePolicy,
+		StandardDestructionPolicy, SingletonFutexLock>, Counted<1>>();
+	expectSingleConstruction<OnceSingleton_t<Counted<2>>, Counted<2>>();
+}
+
+constexpr unsigned stressSingletons = 2000;
+
+template<unsigned i>
+struct Stress {
+	/// spread out and repeated, so that ties have to be broken by the order of creation
+	static constexpr unsigned longevity = (i * 7919u) % 500u;
+	~Stress() {
+		lifetimeChecker.order.push_back(longevity);
+	}
+};
+
+template<unsigned ... is>
+void createStressSingletons(std::integer_sequence<unsigned, is...>) {
+	(LifetimeSingleton_t<Stress<is>, Stress<is>::longevity>::get(), ...);
+}
+
+TEST(SingletonTest, longevityStressTest) {
+	// the order is checked by lifetimeChecker when the program exits
+	createStressSingletons(std::make_integer_sequence<unsigned, stressSingletons>{});
+	ASSERT_GE(SingletonLongevityTracker::lifetimeManager.size, stressSingletons);
+}
+
+/**
+ * Keeps the destructor of the singleton so that the test can destroy it
+ */
+template<int tag>
+struct ManualDestruction {
+	inline static void(*destroy)() = nullptr;
+	static void scheduleDestruction(void(*dtor)()) noexcept {
+		destroy = dtor;
+	}
+};
+
+template<int tag>
+struct Tracked {
+	inline static int constructed = 0;
+	inline static int destroyed = 0;
+	int value = 7;
+	Tracked() { ++constructed; }
+	~Tracked() { ++destroyed; }
+};
+
+TEST(SingletonTest, staticStorageTest) {
+	using Revived = Singleton<Tracked<0>, ReviveDeadRefPolicy, StaticStorageCreatePolicy, ManualDestruction<0>>;
+	Revived revived;
+	auto* first = &revived.get();
+	ASSERT_EQ(reinterpret_cast<std::uintptr_t>(first) % 64, 0u);
+	ASSERT_EQ(Tracked<0>::constructed, 1);
+	ManualDestruction<0>::destroy();
+	ASSERT_EQ(Tracked<0>::destroyed, 1);
+	ASSERT_EQ(&revived.get(), first);
+	ASSERT_EQ(Tracked<0>::constructed, 2);
+
+	using Erroring = Singleton<Tracked<1>, ErrorDeadRefPolicy, StaticStorageCreatePolicy, ManualDestruction<1>>;
+	Erroring erroring;
+	ASSERT_EQ(erroring.get().value, 7);
+	ManualDestruction<1>::destroy();
+	ASSERT_THROW(erroring.get(), DeadReferenceException);
+}
+
+struct Config {
+	inline static int destroyed = 0;
+	int value = 3;
+	constexpr Config() = default;
+	~Config() { ++destroyed; }
+};
+
+using ConstantConfig = Singleton<Config, ReviveDeadRefPolicy, ConstantInitCreatePolicy, ManualDestruction<2>>;
+// usable during the dynamic initialization of other globals, without ordering problems
+static const int configValue = ConstantConfig::get().value;
+
+TEST(SingletonTest, constantInitTest) {
+	ASSERT_EQ(configValue, 3);
+	ConstantConfig::get().value = 4;
+	ASSERT_EQ(ConstantConfig::get().value, 4);
+	ASSERT_NE(ManualDestruction<2>::destroy, nullptr);
+	ManualDestruction<2>::destroy();
+	ASSERT_EQ(Config::destroyed, 1);
+	ASSERT_EQ(ConstantConfig::get().value, 3);
+	ASSERT_EQ(reinterpret_cast<std::uintptr_t>(&ConstantConfig::get()) % 64, 0u);
+}
+
+std::mutex constructionLock;
+std::vector<std::string> constructionOrder;
+
+/**
+ * A registered singleton, destroyed after the registered singletons that are deeper in the dependency graph
+ */
+template<unsigned depth>
+struct Dependent {
+	explicit Dependent(const char* name) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		std::lock_guard<std::mutex> lk(constructionLock);
+		constructionOrder.push_back(name);
+	}
+	~Dependent() {
+		lifetimeChecker.order.push_back(std::numeric_limits<unsigned>::max() - depth);
+	}
+};
+struct Storage : Dependent<0> { Storage() : Dependent("Storage") {} };
+struct Index : Dependent<1> { Index() : Dependent("Index") {} };
+struct Cache : Dependent<1> { Cache() : Dependent("Cache") {} };
+struct Service : Dependent<2> { Service() : Dependent("Service") {} };
+using StorageSingleton = DependentSingleton_t<Storage>;
+using IndexSingleton = DependentSingleton_t<Index>;
+using CacheSingleton = DependentSingleton_t<Cache>;
+using ServiceSingleton = DependentSingleton_t<Service>;
+
+static const SingletonRegistration<ServiceSingleton, CacheSingleton, IndexSingleton> serviceRegistration;
+static const SingletonRegistration<CacheSingleton, StorageSingleton> cacheRegistration;
+static const SingletonRegistration<IndexSingleton, StorageSingleton> indexRegistration;
+static const SingletonRegistration<StorageSingleton> storageRegistration;
+
+TEST(SingletonTest, warmUpTest) {
+	const auto times = warmUpSingletons(4);
+	ASSERT_EQ(times.size(), 4u);
+	for (std::size_t i = 1; i < times.size(); ++i) {
+		ASSERT_GE(times[i - 1].time, times[i].time);
+	}
+	ASSERT_NE(std::find_if(times.begin(), times.end(), [](const auto& t) { return t.type == typeId<Service>(); }),
+		times.end());
+	const auto position = [](const char* name) {
+		return std::find(constructionOrder.begin(), constructionOrder.end(), name) - constructionOrder.begin();
+	};
+	ASSERT_EQ(constructionOrder.size(), 4u);
+	ASSERT_EQ(position("Storage"), 0);
+	ASSERT_LT(position("Cache"), position("Service"));
+	ASSERT_LT(position("Index"), position("Service"));
+	// already created, warming up again only gets them
+	ASSERT_EQ(warmUpSingletons([](std::function<void()> job) { job(); }).size(), 4u);
+	ASSERT_EQ(constructionOrder.size(), 4u);
+	// the destruction order is checked by lifetimeChecker when the program exits
+}
+
+struct Routes {
+	inline static std::atomic<int> live{ 0 };
+	int version = 0;
+	/// always version * 2, a reader seeing anything else read a torn or deleted version
+	int check = 0;
+	Routes() { ++live; }
+	Routes(int version) : version(version), check(version * 2) { ++live; }
+	~Routes() { check = -1; --live; }
+};
+
+TEST(SingletonTest, swappableTest) {
+	using Table = SwappableSingleton<Routes, ReviveDeadRefPolicy, ManualDestruction<3>>;
+	ASSERT_EQ(Table::get()->version, 0);
+	{
+		auto old = Table::get();
+		Table::publish(std::make_unique<Routes>(1));
+		ASSERT_EQ(old->version, 0);
+		ASSERT_EQ(old->check, 0);
+		ASSERT_EQ(Table::get()->version, 1);
+		ASSERT_EQ(Table::retiredVersions(), 1u);
+	}
+	Table::synchronize();
+	ASSERT_EQ(Table::retiredVersions(), 0u);
+	ASSERT_EQ(Routes::live, 1);
+
+	std::atomic<bool> done{ false };
+	std::atomic<bool> consistent{ true };
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 3; ++t) {
+		readers.emplace_back([&]() {
+			int last = 0;
+			while (!done.load()) {
+				auto routes = Table::get();
+				if (routes->check != routes->version * 2 || routes->version < last)
+					consistent = false;
+				last = routes->version;
+			}
+		});
+	}
+	for (int v = 2; v < 2000; ++v) {
+		Table::publish(std::make_unique<Routes>(v));
+	}
+	done = true;
+	for (auto& t : readers)
+		t.join();
+	ASSERT_TRUE(consistent);
+	Table::synchronize();
+	ASSERT_EQ(Routes::live, 1);
+	ASSERT_EQ(Table::get()->version, 1999);
+
+	ManualDestruction<3>::destroy();
+	ASSERT_EQ(Routes::live, 0);
+	// revived by the dead reference policy
+	ASSERT_EQ(Table::get()->version, 0);
+}
+
+TEST(SingletonTest, swappableDeadReferenceTest) {
+	using Table = SwappableSingleton<Routes, ErrorDeadRefPolicy, ManualDestruction<4>>;
+	{
+		Table handle;
+		Table::publish(std::make_unique<Routes>(5));
+	}
+	ASSERT_EQ(Table::get()->version, 5);
+	ManualDestruction<4>::destroy();
+	ASSERT_THROW(Table::get(), DeadReferenceException);
+	ASSERT_THROW(Table::publish(std::make_unique<Routes>(6)), DeadReferenceException);
+}
+
+TEST(SingletonTest, swappablePinnedDestructionTest) {
+	using Table = SwappableSingleton<Routes, ReviveDeadRefPolicy, ManualDestruction<11>>;
+	const auto live = Routes::live.load();
+	Table::publish(std::make_unique<Routes>(7));
+	std::atomic<bool> pinned{ false };
+	std::atomic<bool> release{ false };
+	std::thread reader([&]() {
+		auto routes = Table::get();
+		pinned = true;
+		while (!release)
+			std::this_thread::yield();
+		ASSERT_EQ(routes->check, 14);
+	});
+	while (!pinned)
+		std::this_thread::yield();
+	// does not wait for the reader
+	ManualDestruction<11>::destroy();
+	ASSERT_EQ(Table::retiredVersions(), 1u);
+	release = true;
+	reader.join();
+	Table::synchronize();
+	ASSERT_EQ(Table::retiredVersions(), 0u);
+	ASSERT_EQ(Routes::live, live);
+}
+
+struct Account {
+	std::uint64_t balance = 0;
+	/// always equal to balance, a reader seeing anything else read a torn write
+	std::uint64_t audit = 0;
+};
+
+template<typename Single>
+void expectExclusiveWrites() {
+	Single handle;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([]() {
+			for (int i = 0; i < 1000; ++i) {
+				auto account = Single::get();
+				++account->balance;
+				++account->audit;
+			}
+		});
+	}
+	for (auto& t : threads)
+		t.join();
+	ASSERT_EQ(Single::get()->balance, 4000u);
+	ASSERT_EQ((*Single::get()).audit, 4000u);
+}
+
+template<template<typename> typename access, int tag>
+using AccessSingleton = Singleton<Tagged<Account, tag>, ErrorDeadRefPolicy, FreeStoreCreatePolicy,
+	StandardDestructionPolicy, SingletonLockGuard, access>;
+
+TEST(SingletonTest, accessPolicyTest) {
+	expectExclusiveWrites<LockedSingleton_t<Tagged<Account, 0>>>();
+	expectExclusiveWrites<SharedLockedSingleton_t<Tagged<Account, 1>>>();
+	expectExclusiveWrites<AccessSingleton<SpinLockAccess, 2>>();
+	expectExclusiveWrites<AccessSingleton<SeqLockAccess, 3>>();
+	using SharedLocked = SharedLockedSingleton_t<Tagged<Account, 1>>;
+	ASSERT_EQ(SharedLocked::read()->balance, 4000u);
+
+	using SeqLocked = AccessSingleton<SeqLockAccess, 4>;
+	SeqLocked handle;
+	std::atomic<bool> done{ false };
+	std::thread writer([&done]() {
+		for (int i = 0; i < 10000; ++i) {
+			auto account = SeqLocked::get();
+			++account->balance;
+			++account->audit;
+		}
+		done = true;
+	});
+	bool consistent = true;
+	while (!done) {
+		const Tagged<Account, 4> copy = SeqLocked::read();
+		consistent = consistent && copy.balance == copy.audit;
+	}
+	writer.join();
+	ASSERT_TRUE(consistent);
+	ASSERT_EQ(SeqLocked::read().balance, 10000u);
+	{
+		// the writer modifies a copy, which is published when the proxy is destroyed
+		auto account = SeqLocked::get();
+		account->balance = 0;
+		ASSERT_EQ(SeqLocked::read().balance, 10000u);
+	}
+	ASSERT_EQ(SeqLocked::read().balance, 0u);
+	static_assert(std::is_same_v<decltype(Singleton<Logger>::get()), Logger&>);
+}
+
+template<int tag>
+struct SlowTable {
+	inline static std::atomic<int> constructed{ 0 };
+	std::thread::id builder = std::this_thread::get_id();
+	SlowTable() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		++constructed;
+	}
+};
+
+TEST(SingletonTest, prefetchTest) {
+	using Table = Singleton<SlowTable<0>, ReviveDeadRefPolicy, FreeStoreCreatePolicy, ManualDestruction<5>,
+		SingletonLockGuard>;
+	using AsyncTable = AsyncSingleton<Table>;
+	static_assert(!PheonixSingleton_t<SlowTable<0>>::lockedCreation);
+	AsyncTable::prefetch();
+	AsyncTable::prefetch();
+	auto& table = AsyncTable::getAsync().get();
+	ASSERT_NE(table.builder, std::this_thread::get_id());
+	ASSERT_EQ(SlowTable<0>::constructed, 1);
+	ASSERT_EQ(&Table::get(), &table);
+	ASSERT_EQ(&AsyncTable::getAsync().get(), &table);
+
+	ManualDestruction<5>::destroy();
+	ASSERT_FALSE(Table::created());
+	auto revived = AsyncTable::getAsync();
+	ASSERT_NE(revived.get().builder, std::this_thread::get_id());
+	ASSERT_EQ(SlowTable<0>::constructed, 2);
+	ASSERT_EQ(&Table::get(), &revived.get());
+
+	using Locked = LockedSingleton_t<SlowTable<1>>;
+	Locked lockedHandle;
+	AsyncSingleton<Locked>::getAsync().get();
+	ASSERT_NE(Locked::get()->builder, std::this_thread::get_id());
+
+	using Erroring = Singleton<SlowTable<2>, ErrorDeadRefPolicy, FreeStoreCreatePolicy, ManualDestruction<6>,
+		SingletonLockGuard>;
+	{
+		Erroring handle;
+		AsyncSingleton<Erroring>::getAsync().wait();
+	}
+	ManualDestruction<6>::destroy();
+	auto failed = AsyncSingleton<Erroring>::getAsync();
+	ASSERT_THROW(failed.get(), DeadReferenceException);
+	ASSERT_THROW(Erroring::get(), DeadReferenceException);
+}
+
+template<int tag>
+struct Timed {
+	Timed() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	~Timed() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+};
+
+template<typename T>
+SingletonLifecycle lifecycleOf() {
+	for (const auto& single : singletonTelemetry()) {
+		if (single.type == typeId<T>().name())
+			return single;
+	}
+	throw std::runtime_error("Singleton not recorded");
+}
+
+TEST(SingletonTest, telemetryTest) {
+	using Single = Singleton<Timed<0>, ReviveDeadRefPolicy, FreeStoreCreatePolicy, ManualDestruction<7>,
+		SingletonLockGuard, DirectAccess, SingletonTelemetry>;
+	Single::get();
+	Single::get();
+	markSingletonSteadyState();
+	std::thread([]() { Single::get(); }).join();
+	ManualDestruction<7>::destroy();
+
+	auto single = lifecycleOf<Timed<0>>();
+	ASSERT_EQ(single.creations, 1u);
+	ASSERT_EQ(single.destructions, 1u);
+	ASSERT_GE(single.construction, std::chrono::milliseconds(5));
+	ASSERT_GE(single.destruction, std::chrono::milliseconds(2));
+	ASSERT_EQ(single.creator, std::this_thread::get_id());
+	ASSERT_EQ(single.startupGets, 2u);
+	ASSERT_EQ(single.steadyGets, 1u);
+
+	using Contended = TimedSingleton_t<Timed<1>>;
+	Contended handle;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([]() { Contended::get(); });
+	}
+	for (auto& t : threads)
+		t.join();
+	auto contended = lifecycleOf<Timed<1>>();
+	ASSERT_EQ(contended.creations, 1u);
+	ASSERT_EQ(contended.steadyGets, 4u);
+	// a thread that lost the race waited for the winner to construct the object
+	ASSERT_GE(contended.lockWait, std::chrono::milliseconds(1));
+
+	std::stringstream report;
+	printSingletonTelemetry(report);
+	ASSERT_NE(report.str().find(typeId<Timed<0>>().name()), std::string::npos);
+}
+
+struct Lookups;
+
+template<int tag>
+struct LookupTable {
+	inline static int live = 0;
+	std::uint64_t entries[64]{};
+	LookupTable() {
+		++live;
+	}
+	~LookupTable() {
+		--live;
+	}
+};
+
+template<int tag>
+struct HugeTable {
+	std::byte data[3 * 1024 * 1024];
+};
+
+TEST(SingletonTest, familyTest) {
+	using Family = SingletonFamily<Lookups>;
+	using First = Singleton<LookupTable<0>, ReviveDeadRefPolicy, Family::CreatePolicy, ManualDestruction<8>>;
+	using Second = Singleton<LookupTable<1>, ReviveDeadRefPolicy, Family::CreatePolicy, ManualDestruction<9>>;
+	auto* first = &First::get();
+	auto* second = &Second::get();
+	auto usage = Family::usage();
+	ASSERT_GE(usage.reserved, 2 * 1024 * 1024u);
+	ASSERT_EQ(usage.members, 2u);
+	ASSERT_EQ(usage.overflow, 0u);
+	ASSERT_GE(usage.used, 2 * sizeof(LookupTable<0>));
+	// both are in the same reservation
+	const auto distance = reinterpret_cast<std::uintptr_t>(second) - reinterpret_cast<std::uintptr_t>(first);
+	ASSERT_LT(distance, usage.reserved);
+	ASSERT_EQ(reinterpret_cast<std::uintptr_t>(first) % 64, 0u);
+
+	ManualDestruction<8>::destroy();
+	ASSERT_EQ(LookupTable<0>::live, 0);
+	ASSERT_EQ(Family::usage().members, 1u);
+	// revived in the same place
+	ASSERT_EQ(&First::get(), first);
+	ASSERT_EQ(Family::usage().used, usage.used);
+
+	using Huge = Singleton<HugeTable<0>, ReviveDeadRefPolicy, Family::CreatePolicy, ManualDestruction<10>>;
+	Huge::get();
+	ASSERT_EQ(Family::usage().overflow, sizeof(HugeTable<0>));
+	ASSERT_EQ(Family::usage().members, 3u);
+	ManualDestruction<10>::destroy();
+	ManualDestruction<9>::destroy();
+	ManualDestruction<8>::destroy();
+	ASSERT_EQ(Family::usage().overflow, 0u);
+	ASSERT_EQ(Family::usage().members, 0u);
+	ASSERT_EQ(LookupTable<0>::live + LookupTable<1>::live, 0);
+}
+
+int scheduledInOtherUnit();
+
+TEST(SingletonTest, otherUnitTest) {
+	ASSERT_EQ(scheduledInOtherUnit(), 42);
+}
+
 int main(int argc, char** argv) {
 	testing::InitGoogleTest(&argc, argv);
 	return RUN_ALL_TESTS();
@@ -0,0 +1,14 @@
+// A second translation unit of SingletonTest, the singleton headers must not define anything twice
+#include <Singleton.hpp>
+#include <SingletonRegistry.hpp>
+#include <SwappableSingleton.hpp>
+#include <SingletonTelemetry.hpp>
+#include <SingletonFamily.hpp>
+
+int scheduledInOtherUnit() {
+	struct Unit {
+		int value = 42;
+	};
+	return SUtil::Singleton<Unit, SUtil::ReviveDeadRefPolicy, SUtil::FreeStoreCreatePolicy,
+		SUtil::LongevityDestructionPolicy<1>>::get().value;
+}
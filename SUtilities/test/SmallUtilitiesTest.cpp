@@ -1,7 +1,19 @@
 #include <gtest/gtest.h>
 #include <Visitable.hpp>
 #include <Visitor.hpp>
+#include <ClosedVisitable.hpp>
+#include <VisitorAlgorithms.hpp>
+#include <PolyCollection.hpp>
+#include <MultiVisitor.hpp>
+#include <CachingVisitor.hpp>
+#include <StaticVisitable.hpp>
+#include <Traversal.hpp>
+#include <AsyncVisitor.hpp>
+#include <Serialization.hpp>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
+#include <thread>
 #include <Cast.hpp>
 
 using namespace SUtil;
@@ -50,7 +62,15 @@ TEST(VisitorTest, visitorTest) {
 TEST(VisitorTest, constVisitorTest) {
 	struct ConstVisit : public ImmutableBaseVisitable<> {
 		MAKE_CONST_VISITABLE(void);
+		VISITABLE_TYPE_ID
 	};
+	// the split macros can still be combined, like MAKE_VISITABLE
+	struct SplitVisit : public BaseVisitable<> {
+		MAKE_CONST_VISITABLE(void)
+		MAKE_MUTABLE_VISITABLE(void)
+		VISITABLE_TYPE_ID
+	};
+	ASSERT_EQ(SplitVisit().dynamicTypeId(), typeId<SplitVisit>());
 	struct FluidVisitable :
 		public BaseVisitable<> {
 
@@ -98,6 +118,935 @@ TEST(VisitorTest, constVisitorTest) {
 	ASSERT_THROW(cFluid.accept(ncv), UnknownVisitorException);
 }
 
+TEST(VisitorTest, tableDispatchTest) {
+	using TableVisitable = BaseVisitable<int, ExceptionUnknownPolicy,
+		MutableAndConstVisitablePolicy, TableDispatchPolicy>;
+	struct Leaf : public TableVisitable {
+		MAKE_VISITABLE(int);
+	};
+	struct Branch : public TableVisitable {
+		MAKE_VISITABLE(int);
+	};
+	struct Unvisited : public TableVisitable {
+		MAKE_VISITABLE(int);
+	};
+
+	class MixedVisitor : public Visitor<int, Leaf, const Leaf, const Branch> {
+	public:
+		int visit(Leaf&) override { return 1; }
+		int visit(const Leaf&) override { return 2; }
+		int visit(const Branch&) override { return 3; }
+	};
+
+	// visitor with a VisitorSingle base that is not in its dispatch table
+	class ExtendedVisitor : public Visitor<int, Leaf>, public VisitorSingle<Unvisited, int> {
+	public:
+		int visit(Leaf&) override { return 4; }
+		int visit(Unvisited&) override { return 5; }
+	};
+
+	Leaf leaf;
+	const Leaf cLeaf;
+	Branch branch;
+	const Branch cBranch;
+	Unvisited unvisited;
+	MixedVisitor mv;
+	ExtendedVisitor ev;
+	ASSERT_NE(mv.dispatchTable(), nullptr);
+	ASSERT_EQ(leaf.accept(mv), 1);
+	ASSERT_EQ(cLeaf.accept(mv), 2);
+	ASSERT_EQ(branch.accept(mv), 3);
+	ASSERT_EQ(cBranch.accept(mv), 3);
+	ASSERT_THROW(unvisited.accept(mv), UnknownVisitorException);
+	ASSERT_EQ(leaf.accept(ev), 4);
+	ASSERT_EQ(unvisited.accept(ev), 5);
+	ASSERT_THROW(branch.accept(ev), UnknownVisitorException);
+	ASSERT_THROW(cLeaf.accept(ev), UnknownVisitorException);
+}
+
+TEST(VisitorTest, cachedDispatchTest) {
+	using CachedVisitable = BaseVisitable<int, ExceptionUnknownPolicy,
+		MutableAndConstVisitablePolicy, CachedDispatchPolicy<>>;
+	struct Leaf : public CachedVisitable {
+		MAKE_VISITABLE(int);
+	};
+	struct Unvisited : public CachedVisitable {
+		MAKE_VISITABLE(int);
+	};
+
+	class ConstVisitor : public Visitor<int, const Leaf> {
+	public:
+		int visit(const Leaf&) override { return 1; }
+	};
+	// VisitorSingle<Leaf, int> is not the first base so the cached offset is non zero
+	class OffsetVisitor : public Visitor<int, Unvisited>, public VisitorSingle<Leaf, int> {
+	public:
+		int value = 2;
+		int visit(Unvisited&) override { return 3; }
+		int visit(Leaf&) override { return value; }
+	};
+
+	Leaf leaf;
+	const Leaf cLeaf;
+	Unvisited unvisited;
+	ConstVisitor cv;
+	OffsetVisitor ov;
+	resetDispatchCacheStats();
+	ASSERT_EQ(leaf.accept(cv), 1);
+	ASSERT_EQ(leaf.accept(cv), 1);
+	ASSERT_EQ(cLeaf.accept(cv), 1);
+	ASSERT_EQ(leaf.accept(ov), 2);
+	ov.value = 4;
+	ASSERT_EQ(leaf.accept(ov), 4);
+	ASSERT_EQ(unvisited.accept(ov), 3);
+	ASSERT_THROW(unvisited.accept(cv), UnknownVisitorException);
+	ASSERT_THROW(unvisited.accept(cv), UnknownVisitorException);
+	ASSERT_THROW(cLeaf.accept(ov), UnknownVisitorException);
+	ASSERT_THROW(cLeaf.accept(ov), UnknownVisitorException);
+	const auto stats = dispatchCacheStats();
+	ASSERT_EQ(stats.misses, 6u);
+	ASSERT_EQ(stats.hits, 4u);
+	ASSERT_DOUBLE_EQ(stats.hitRate(), 0.4);
+	// the counts of a thread are kept after it exits
+	std::thread([&]() { leaf.accept(cv); }).join();
+	ASSERT_EQ(dispatchCacheStats().hits, 5u);
+	resetDispatchCacheStats();
+	ASSERT_EQ(dispatchCacheStats().hits, 0u);
+	ASSERT_EQ(leaf.accept(cv), 1);
+	ASSERT_EQ(dispatchCacheStats().hits, 1u);
+
+	// both BaseVisitor subobjects have the same dynamic type, but are at different offsets from VisitorSingle<Leaf, int>
+	class TwoVisitors : public Visitor<int, Unvisited>, public Visitor<int, Leaf> {
+	public:
+		int value = 6;
+		int visit(Unvisited&) override { return 7; }
+		int visit(Leaf&) override { return value; }
+	};
+	TwoVisitors tv;
+	BaseVisitor& first = static_cast<Visitor<int, Unvisited>&>(tv);
+	BaseVisitor& second = static_cast<Visitor<int, Leaf>&>(tv);
+	ASSERT_EQ(leaf.accept(first), 6);
+	ASSERT_EQ(leaf.accept(second), 6);
+	ASSERT_EQ(unvisited.accept(second), 7);
+	ASSERT_EQ(unvisited.accept(first), 7);
+}
+
+namespace {
+	struct Circle;
+	struct Square;
+	using Shapes = TL::TypeList<Circle, Square>;
+	struct Circle : public ClosedVisitableNode<Circle, Shapes, int> {
+		int radius = 2;
+	};
+	struct Square : public ClosedVisitableNode<Square, Shapes, int> {
+		int side = 3;
+	};
+}
+
+TEST(VisitorTest, closedVisitableTest) {
+	class AreaVisitor : public Visitor<int, Circle, const Square> {
+	public:
+		int visit(Circle& c) override { return 3 * c.radius * c.radius; }
+		int visit(const Square& s) override { return s.side * s.side; }
+	};
+	class ConstVisitor : public Visitor<int, const Circle, const Square> {
+	public:
+		int visit(const Circle&) override { return 1; }
+		int visit(const Square&) override { return 2; }
+	};
+	class PartialVisitor : public Visitor<int, Circle> {
+	public:
+		int visit(Circle&) override { return 0; }
+	};
+	static_assert(ClosedVisitorOf<AreaVisitor, Shapes, int>);
+	static_assert(!ClosedVisitorOf<PartialVisitor, Shapes, int>);
+	static_assert(!ClosedVisitorOf<AreaVisitor, Shapes, void>);
+	static_assert(ConstClosedVisitorOf<ConstVisitor, Shapes, int>);
+	static_assert(!ConstClosedVisitorOf<AreaVisitor, Shapes, int>);
+	static_assert(sizeof(Circle) == sizeof(int) * 2);
+	static_assert(std::is_copy_assignable_v<Circle> && !std::is_copy_assignable_v<ClosedVisitable<Shapes, int>>);
+
+	Circle c;
+	Square s;
+	const Square cs;
+	ClosedVisitable<Shapes, int>& shape = s;
+	AreaVisitor av;
+	ConstVisitor cv;
+	ASSERT_EQ(c.discriminant(), 0);
+	ASSERT_TRUE(shape.holds<Square>());
+	ASSERT_FALSE(shape.holds<Circle>());
+	ASSERT_EQ(c.accept(av), 12);
+	ASSERT_EQ(shape.accept(av), 9);
+	ASSERT_EQ(cs.accept(cv), 2);
+	ASSERT_EQ(c.accept(cv), 1);
+	ASSERT_EQ(shape.accept(cv), 2);
+}
+
+TEST(VisitorTest, acceptAllTest) {
+	struct Num : public BaseVisitable<int> {
+		int value;
+		explicit Num(int value) : value(value) {}
+		MAKE_VISITABLE(int);
+	};
+	struct Neg : public BaseVisitable<int> {
+		int value;
+		explicit Neg(int value) : value(value) {}
+		MAKE_VISITABLE(int);
+	};
+	struct Other : public BaseVisitable<int> {
+		MAKE_VISITABLE(int);
+	};
+	class OrderVisitor : public Visitor<int, Num, const Neg> {
+	public:
+		std::stringstream ss;
+		int visit(Num& n) override {
+			ss << n.value << " ";
+			return n.value;
+		}
+		int visit(const Neg& n) override {
+			ss << -n.value << " ";
+			return -n.value;
+		}
+	};
+
+	Num n1(1), n2(2), n3(3);
+	Neg m1(1), m2(2);
+	std::vector<BaseVisitable<int>*> nodes = { &n1, &m1, &n2, &m2, &n3 };
+	OrderVisitor grouped;
+	acceptAll(nodes, grouped, VisitOrder::grouped);
+	ASSERT_EQ(grouped.ss.str(), "1 2 3 -1 -2 ");
+
+	OrderVisitor preserved;
+	acceptAll(nodes, preserved);
+	ASSERT_EQ(preserved.ss.str(), "1 -1 2 -2 3 ");
+
+	OrderVisitor summer;
+	ASSERT_EQ(acceptAll(nodes, summer, 10, std::plus<int>{}), 13);
+	ASSERT_EQ(acceptAll(std::vector<BaseVisitable<int>*>{}, summer, 10, std::plus<int>{}), 10);
+
+	// only visit(const Neg&) can visit const elements
+	std::vector<const BaseVisitable<int>*> constNodes = { &m1, &m2 };
+	ASSERT_EQ(acceptAll(constNodes, summer, 0, std::plus<int>{}), -3);
+	constNodes.push_back(&n1);
+	ASSERT_THROW(acceptAll(constNodes, summer), UnknownVisitorException);
+
+	std::vector<std::unique_ptr<BaseVisitable<int>>> owned;
+	owned.push_back(std::make_unique<Num>(5));
+	owned.push_back(std::make_unique<Other>());
+	ASSERT_THROW(acceptAll(owned, summer), UnknownVisitorException);
+
+	// like accept(), a visitable that only accepts const visitors is only visited by visit(const T&)
+	struct Frozen : public ImmutableBaseVisitable<int> {
+		MAKE_CONST_VISITABLE(int);
+		VISITABLE_TYPE_ID
+	};
+	class FrozenVisitor : public Visitor<int, Frozen, const Frozen> {
+	public:
+		int visit(Frozen&) override { return 1; }
+		int visit(const Frozen&) override { return 2; }
+	};
+	Frozen f1, f2;
+	std::vector<ImmutableBaseVisitable<int>*> frozen = { &f1, &f2 };
+	FrozenVisitor fv;
+	ASSERT_EQ(f1.accept(fv), 2);
+	ASSERT_EQ(acceptAll(frozen, fv, 0, std::plus<int>{}), 4);
+	ASSERT_EQ(acceptAll(frozen, fv, 0, std::plus<int>{}, VisitOrder::grouped), 4);
+}
+
+TEST(VisitorTest, parallelAcceptAllTest) {
+	struct Num : public BaseVisitable<long> {
+		long value;
+		explicit Num(long value) : value(value) {}
+		MAKE_VISITABLE(long);
+	};
+	struct Bad : public BaseVisitable<long> {
+		MAKE_VISITABLE(long);
+	};
+	class SumVisitor : public Visitor<long, Num> {
+	public:
+		long visited = 0;
+		long visit(Num& n) override {
+			++visited;
+			return n.value;
+		}
+	};
+	std::vector<std::unique_ptr<BaseVisitable<long>>> nodes;
+	for (long i = 1; i <= 10000; ++i)
+		nodes.push_back(std::make_unique<Num>(i));
+	SumVisitor visitor;
+	const auto expected = acceptAll(nodes, visitor, 0l, std::plus<long>{});
+	ASSERT_EQ(expected, 50005000);
+	for (unsigned threads : { 1u, 2u, 4u, 7u }) {
+		for (std::size_t chunk : { 1u, 64u, 100000u }) {
+			ASSERT_EQ(parallelAcceptAll(nodes, visitor, 0l, std::plus<long>{}, { threads, chunk }), expected);
+		}
+	}
+	ASSERT_EQ(parallelAcceptAll(std::vector<BaseVisitable<long>*>{}, visitor, 3l, std::plus<long>{}), 3);
+	// every thread reduces with its own copy of a stateful reduce
+	auto counting = [calls = 0l](long acc, long value) mutable {
+		++calls;
+		return acc + value;
+	};
+	ASSERT_EQ(parallelAcceptAll(nodes, visitor, 0l, counting, { 4, 16 }), expected);
+	// every thread visits with its own copy
+	parallelAcceptAll(nodes, visitor, { 4, 16 });
+	ASSERT_EQ(visitor.visited, 10000);
+
+	nodes.insert(nodes.begin() + 5000, std::make_unique<Bad>());
+	ASSERT_THROW(parallelAcceptAll(nodes, visitor, 0l, std::plus<long>{}, { 4, 16 }), UnknownVisitorException);
+}
+
+TEST(VisitorTest, compactVisitorTest) {
+	using CachedVisitable = BaseVisitable<int, ExceptionUnknownPolicy,
+		MutableAndConstVisitablePolicy, CachedDispatchPolicy<>>;
+	struct A : public BaseVisitable<int> {
+		MAKE_VISITABLE(int);
+	};
+	struct B : public BaseVisitable<int> {
+		MAKE_VISITABLE(int);
+	};
+	struct C : public CachedVisitable {
+		MAKE_VISITABLE(int);
+	};
+	struct D : public BaseVisitable<int> {
+		MAKE_VISITABLE(int);
+	};
+	class Compact : public CompactVisitor<int, A, const B, C> {
+	public:
+		int visit(A&) override { return 1; }
+		int visit(const B&) override { return 2; }
+		int visit(C&) override { return 3; }
+	};
+	static_assert(sizeof(Compact) == sizeof(BaseVisitor));
+	static_assert(sizeof(Compact) < sizeof(Visitor<int, A, const B, C>));
+
+	A a;
+	B b;
+	const B cb;
+	C c;
+	D d;
+	Compact visitor;
+	// searched before the dynamic_casts, which could not find its visit functions
+	ASSERT_TRUE(visitor.dispatchTable()->tableOnly());
+	ASSERT_EQ(a.accept(visitor), 1);
+	ASSERT_EQ(b.accept(visitor), 2);
+	ASSERT_EQ(cb.accept(visitor), 2);
+	ASSERT_EQ(c.accept(visitor), 3);
+	ASSERT_EQ(c.accept(visitor), 3);
+	ASSERT_THROW(d.accept(visitor), UnknownVisitorException);
+
+	std::vector<BaseVisitable<int>*> nodes = { &a, &b, &d, &a };
+	ASSERT_THROW(acceptAll(nodes, visitor), UnknownVisitorException);
+	nodes.pop_back();
+	nodes.back() = &a;
+	ASSERT_EQ(acceptAll(nodes, visitor, 0, std::plus<int>{}), 4);
+	ASSERT_EQ(parallelAcceptAll(nodes, visitor, 0, std::plus<int>{}, { 2, 1 }), 4);
+}
+
+TEST(VisitorTest, cachingVisitorTest) {
+	struct Leaf : public BaseVisitable<int>, public Versioned {
+		int value;
+		explicit Leaf(int value) : value(value) {}
+		MAKE_VISITABLE(int);
+	};
+	struct Sum : public BaseVisitable<int>, public Versioned {
+		std::vector<BaseVisitable<int>*> children;
+		MAKE_VISITABLE(int);
+	};
+	class SumVisitor : public CachingVisitor<int, const Leaf, const Sum> {
+	public:
+		int visits = 0;
+		using BasicCachingVisitor::BasicCachingVisitor;
+		int visit(const Leaf& l) override {
+			++visits;
+			return l.value;
+		}
+		int visit(const Sum& s) override {
+			++visits;
+			int total = 0;
+			for (auto* child : s.children)
+				total += child->dynamicTypeId() == typeId<Leaf>() ? evaluate(static_cast<Leaf&>(*child))
+					: evaluate(static_cast<Sum&>(*child));
+			return total;
+		}
+	};
+
+	// root = (1 + 2) + 3
+	Leaf one(1), two(2), three(3);
+	Sum inner, root;
+	inner.children = { &one, &two };
+	root.children = { &inner, &three };
+	SumVisitor visitor;
+	ASSERT_EQ(visitor.evaluate(root), 6);
+	ASSERT_EQ(visitor.visits, 5);
+	ASSERT_EQ(visitor.evaluate(root), 6);
+	ASSERT_EQ(visitor.visits, 5);
+
+	// only the changed leaf and the nodes that depend on it are visited again
+	two.value = 20;
+	two.markDirty();
+	ASSERT_EQ(visitor.evaluate(root), 24);
+	ASSERT_EQ(visitor.visits, 8);
+	ASSERT_EQ(visitor.evaluate(three), 3);
+	ASSERT_EQ(visitor.visits, 8);
+
+	// a result computed by another evaluation is a new result for the nodes that depend on it
+	one.value = 10;
+	one.markDirty();
+	ASSERT_EQ(visitor.evaluate(inner), 30);
+	ASSERT_EQ(visitor.visits, 10);
+	ASSERT_EQ(visitor.evaluate(root), 33);
+	ASSERT_EQ(visitor.visits, 11);
+
+	visitor.invalidate(three);
+	ASSERT_EQ(visitor.evaluate(root), 33);
+	ASSERT_EQ(visitor.visits, 13);
+	ASSERT_EQ(visitor.size(), 5);
+	const auto stats = visitor.stats();
+	ASSERT_EQ(stats.misses, 13);
+	ASSERT_EQ(stats.evictions, 0);
+
+	// the least recently used results are evicted, an evicted dependency is recomputed
+	visitor.reserve(2);
+	ASSERT_EQ(visitor.size(), 2);
+	ASSERT_EQ(visitor.stats().evictions, 3);
+	SumVisitor small(2);
+	ASSERT_EQ(small.evaluate(root), 33);
+	ASSERT_EQ(small.size(), 2);
+	ASSERT_EQ(small.evaluate(root), 33);
+	ASSERT_LE(small.size(), 2);
+	visitor.clear();
+	ASSERT_EQ(visitor.size(), 0);
+	static_assert(EvictionPolicy<FifoEvictionPolicy>);
+
+	// validating a dependency chain deeper than the call stack
+	constexpr std::size_t depth = 200000;
+	std::vector<Sum> chain(depth);
+	SumVisitor deep(depth + 1);
+	chain[0].children = { &one };
+	deep.evaluate(chain[0]);
+	for (std::size_t i = 1; i < depth; ++i) {
+		chain[i].children = { &chain[i - 1] };
+		deep.evaluate(chain[i]);
+	}
+	three.markDirty();
+	const auto visits = deep.visits;
+	ASSERT_EQ(deep.evaluate(chain.back()), 10);
+	ASSERT_EQ(deep.visits, visits);
+	one.markDirty();
+	ASSERT_EQ(deep.evaluate(chain[1]), 10);
+	ASSERT_EQ(deep.visits, visits + 3);
+}
+
+TEST(VisitorTest, staticVisitableTest) {
+	struct Node : public BaseVisitable<int> {
+		MAKE_VISITABLE(int);
+	};
+	struct Leaf final : public Node, public StaticVisitable<Leaf> {
+		int value = 2;
+		MAKE_STATIC_VISITABLE(int);
+	};
+	struct Pure final : public StaticVisitable<Pure> {};
+	class DynamicVisitor : public Visitor<int, Leaf, Node> {
+	public:
+		int visit(Leaf& l) override { return l.value; }
+		int visit(Node&) override { return 0; }
+	};
+	class ConstVisitor final : public Visitor<int, const Leaf> {
+	public:
+		int visit(const Leaf& l) override { return l.value * 10; }
+	};
+	// only visits statically
+	struct Doubler {
+		int visit(Leaf& l) const { return l.value * 2; }
+		std::string visit(const Pure&) const { return "pure"; }
+	};
+	class NodeVisitor : public Visitor<int, Node> {
+	public:
+		int visit(Node&) override { return -1; }
+	};
+
+	Leaf leaf;
+	const Leaf& cLeaf = leaf;
+	Node& node = leaf;
+	DynamicVisitor dv;
+	ConstVisitor cv;
+	Doubler doubler;
+	NodeVisitor nv;
+	ASSERT_EQ(leaf.accept(dv), 2);
+	ASSERT_EQ(node.accept(dv), 2);
+	ASSERT_EQ(cLeaf.accept(cv), 20);
+	ASSERT_EQ(leaf.accept(cv), 20);
+	ASSERT_EQ(node.accept(cv), 20);
+	ASSERT_EQ(leaf.accept(doubler), 4);
+	static_assert(StaticVisitor<DynamicVisitor, Leaf> && StaticVisitor<ConstVisitor, const Leaf>);
+	static_assert(StaticVisitor<ConstVisitor, Leaf> && !StaticVisitor<DynamicVisitor, const Leaf>);
+	ASSERT_EQ(Pure{}.accept(doubler), "pure");
+	// visit(Node&) doesn't visit a Leaf, statically or dynamically
+	static_assert(!StaticVisitor<NodeVisitor, Leaf>);
+	ASSERT_THROW(leaf.accept(nv), UnknownVisitorException);
+	ASSERT_THROW(node.accept(nv), UnknownVisitorException);
+	BaseVisitor& erased = dv;
+	ASSERT_EQ(leaf.accept(erased), 2);
+}
+
+namespace {
+	struct TreeNode : public BaseVisitable<> {
+		std::vector<std::unique_ptr<TreeNode>> kids;
+		const std::vector<std::unique_ptr<TreeNode>>& children() const { return kids; }
+	};
+	struct Branch : public TreeNode {
+		int id;
+		explicit Branch(int id) : id(id) {}
+		MAKE_VISITABLE(void);
+	};
+	struct Tip : public TreeNode {
+		int id;
+		explicit Tip(int id) : id(id) {}
+		MAKE_VISITABLE(void);
+	};
+	class IdVisitor : public Visitor_v<Branch, Tip> {
+	public:
+		std::stringstream ss;
+		void visit(Branch& b) override { ss << b.id << " "; }
+		void visit(Tip& t) override { ss << t.id << "t "; }
+	};
+}
+
+TEST(VisitorTest, traversalTest) {
+	//       0
+	//    1     2t
+	//  3t 4t
+	Branch root(0);
+	root.kids.push_back(std::make_unique<Branch>(1));
+	root.kids.push_back(std::make_unique<Tip>(2));
+	root.kids.front()->kids.push_back(std::make_unique<Tip>(3));
+	root.kids.front()->kids.push_back(std::make_unique<Tip>(4));
+	root.kids.push_back(nullptr);
+	TreeNode& tree = root;
+	auto order = [&tree](TraversalOrder order) {
+		IdVisitor visitor;
+		for (auto& node : traverse(tree, order))
+			node.accept(visitor);
+		return visitor.ss.str();
+	};
+	ASSERT_EQ(order(TraversalOrder::preOrder), "0 1 3t 4t 2t ");
+	ASSERT_EQ(order(TraversalOrder::postOrder), "3t 4t 1 2t 0 ");
+	ASSERT_EQ(order(TraversalOrder::breadthFirst), "0 1 2t 3t 4t ");
+
+	// frames of finished traversals are reused
+	ASSERT_GT(FrameAllocator::cached(), 0);
+	const auto cached = FrameAllocator::cached();
+	{
+		auto nodes = traverse(tree);
+		ASSERT_EQ(FrameAllocator::cached(), cached - 1);
+	}
+	ASSERT_EQ(FrameAllocator::cached(), cached);
+
+	// stopping early
+	IdVisitor visitor;
+	for (auto& node : traverse(tree, TraversalOrder::breadthFirst)) {
+		node.accept(visitor);
+		if (visitor.ss.str().size() > 3)
+			break;
+	}
+	ASSERT_EQ(visitor.ss.str(), "0 1 ");
+
+	// a degenerate tree deeper than the call stack could handle with recursion
+	Branch deep(0);
+	TreeNode* last = &deep;
+	for (int i = 1; i < 200000; ++i) {
+		last->kids.push_back(std::make_unique<Branch>(i));
+		last = last->kids.front().get();
+	}
+	std::size_t count = 0;
+	for ([[maybe_unused]] auto& node : traverse(static_cast<TreeNode&>(deep), TraversalOrder::postOrder))
+		++count;
+	ASSERT_EQ(count, 200000);
+	// unlinks the chain iteratively, the default destructor would recurse
+	while (!deep.kids.empty()) {
+		auto next = std::move(deep.kids.front()->kids);
+		deep.kids = std::move(next);
+	}
+
+	// custom children, values instead of pointers
+	struct Value {
+		int id;
+		std::vector<Value> values;
+	};
+	Value values{ 0, { { 1, {} }, { 2, { { 3, {} } } } } };
+	std::stringstream ss;
+	for (const auto& v : traverse(std::as_const(values), TraversalOrder::postOrder,
+		[](const Value& v) -> const std::vector<Value>& { return v.values; }))
+		ss << v.id;
+	ASSERT_EQ(ss.str(), "1320");
+}
+
+template<typename Collection, typename V>
+concept CanAccept = requires(Collection & c, V & v) {
+	c.accept(v);
+};
+
+TEST(VisitorTest, polyCollectionTest) {
+	struct Ball {
+		int id;
+	};
+	struct Box {
+		std::string name;
+	};
+	using Items = TL::TypeList<Ball, Box>;
+	class ItemVisitor : public Visitor<void, Ball, const Box> {
+	public:
+		std::stringstream ss;
+		void visit(Ball& b) override { ss << b.id << " "; }
+		void visit(const Box& b) override { ss << b.name << " "; }
+	};
+	class BallVisitor : public Visitor<void, Ball> {
+	public:
+		void visit(Ball&) override {}
+	};
+	class ConstItemVisitor : public Visitor<void, const Ball, const Box> {
+	public:
+		int count = 0;
+		void visit(const Ball&) override { ++count; }
+		void visit(const Box&) override { ++count; }
+	};
+	static_assert(!CanAccept<PolyCollection<Items>, BallVisitor>);
+	static_assert(!CanAccept<const PolyCollection<Items>, ItemVisitor>);
+	static_assert(CanAccept<const PolyCollection<Items>, ConstItemVisitor>);
+
+	PolyCollection<Items> items;
+	items.reserve<Ball>(4);
+	auto b1 = items.emplace<Ball>(1);
+	auto box = items.insert(Box{ "box" });
+	auto b2 = items.emplace<Ball>(2);
+	auto b3 = items.emplace<Ball>(3);
+	ASSERT_EQ(items.size(), 4u);
+	ASSERT_EQ(items.size<Ball>(), 3u);
+	ItemVisitor iv;
+	items.accept(iv);
+	ASSERT_EQ(iv.ss.str(), "1 2 3 box ");
+
+	ASSERT_TRUE(items.erase(b1));
+	ASSERT_FALSE(items.erase(b1));
+	ASSERT_EQ(items.get(b1), nullptr);
+	ASSERT_EQ(items.get(b3)->id, 3);
+	ASSERT_EQ(items.get(b2)->id, 2);
+	ASSERT_EQ(items.elements<Ball>()[0].id, 3);
+
+	// the freed slot is reused, the stale handle stays invalid
+	auto b4 = items.emplace<Ball>(4);
+	ASSERT_EQ(items.get(b1), nullptr);
+	ASSERT_EQ(items.get(b4)->id, 4);
+	ItemVisitor afterErase;
+	items.accept(afterErase);
+	ASSERT_EQ(afterErase.ss.str(), "3 2 4 box ");
+	const auto& constItems = items;
+	ConstItemVisitor counter;
+	constItems.accept(counter);
+	ASSERT_EQ(counter.count, 4);
+	ASSERT_EQ(constItems.get(box)->name, "box");
+
+	items.clear();
+	ASSERT_TRUE(items.empty());
+	ASSERT_EQ(items.get(b4), nullptr);
+	ASSERT_EQ(items.get(box), nullptr);
+}
+
+TEST(VisitorTest, multiVisitorTest) {
+	struct Body {
+		virtual ~Body() = default;
+	};
+	struct Ship : public Body {};
+	struct Rock : public Body {};
+	struct Bullet : public Body {};
+	struct Unlisted : public Body {};
+	struct Collide {
+		std::string visit(Ship&, Ship&) { return "ship ship"; }
+		std::string visit(Ship&, Rock&) { return "ship rock"; }
+		std::string visit(const Bullet&, const Body&) { return "bullet body"; }
+	};
+	using Bodies = TL::TypeList<Ship, Rock, Bullet>;
+	using Symmetric = MultiVisitor<std::string, Bodies, Bodies, MultiDispatch::symmetric>;
+	using Asymmetric = MultiVisitor<std::string, Bodies, Bodies>;
+	using Defaulted = MultiVisitor<std::string, TL::TypeList<Ship>, TL::TypeList<Rock>,
+		MultiDispatch::symmetric, DefaultConstructUnknownPolicy>;
+
+	Ship ship;
+	Rock rock;
+	Bullet bullet;
+	Unlisted unlisted;
+	Body& s = ship;
+	Body& r = rock;
+	Body& b = bullet;
+	Collide collide;
+	ASSERT_EQ(Asymmetric::dispatch(collide, s, s), "ship ship");
+	ASSERT_EQ(Asymmetric::dispatch(collide, s, r), "ship rock");
+	ASSERT_THROW(Asymmetric::dispatch(collide, r, s), UnknownVisitorException);
+	ASSERT_EQ(Symmetric::dispatch(collide, r, s), "ship rock");
+	ASSERT_THROW(Symmetric::dispatch(collide, r, r), UnknownVisitorException);
+	ASSERT_EQ(Symmetric::dispatch(collide, b, r), "bullet body");
+	ASSERT_EQ(Symmetric::dispatch(collide, s, b), "bullet body");
+	ASSERT_THROW(Symmetric::dispatch(collide, s, static_cast<Body&>(unlisted)), UnknownVisitorException);
+	// a (Rock, Ship) pair is found by swapping the operands
+	ASSERT_EQ(Defaulted::dispatch(collide, r, s), "ship rock");
+	ASSERT_EQ(Defaulted::dispatch(collide, s, s), "");
+
+	const Body& cb = bullet;
+	const Body& cs = ship;
+	ASSERT_EQ(Symmetric::dispatch(collide, cs, cb), "bullet body");
+	ASSERT_THROW(Symmetric::dispatch(collide, cs, cs), UnknownVisitorException);
+}
+
+TEST(VisitorTest, unknownVisitorPolicyTest) {
+	using Result = VisitResult<int>;
+	struct Known : public BaseVisitable<Result, ExpectedUnknownPolicy> {
+		MAKE_VISITABLE(Result);
+	};
+	struct Unknown : public BaseVisitable<Result, ExpectedUnknownPolicy> {
+		MAKE_VISITABLE(Result);
+	};
+	class KnownVisitor : public Visitor<Result, Known> {
+	public:
+		Result visit(Known&) override {
+			return 2;
+		}
+	};
+
+	Known k1, k2;
+	Unknown u;
+	KnownVisitor v;
+	auto good = k1.accept(v);
+	ASSERT_TRUE(good);
+	ASSERT_EQ(*good, 2);
+	auto bad = u.accept(v);
+	ASSERT_FALSE(bad.has_value());
+	ASSERT_EQ(bad.error().visited, typeId<Unknown>());
+	ASSERT_EQ(bad.value_or(-1), -1);
+	ASSERT_THROW(bad.value(), UnknownVisitorException);
+
+	// failed visits are counted and the rest of the range is still visited
+	std::vector<BaseVisitable<Result, ExpectedUnknownPolicy>*> nodes = { &k1, &u, &k2, &u };
+	const auto stats = tryAcceptAll(nodes, v);
+	ASSERT_EQ(stats.handled, 2);
+	ASSERT_EQ(stats.unhandled, 2);
+	const auto sum = tryAcceptAll(nodes, v, 1, std::plus<int>{}, VisitOrder::preserved);
+	ASSERT_EQ(sum.value, 5);
+	ASSERT_EQ(sum.stats.unhandled, 2);
+
+	struct VoidUnknown : public BaseVisitable<VisitResult<void>, ExpectedUnknownPolicy, MutableAndConstVisitablePolicy,
+		TableDispatchPolicy> {
+		MAKE_VISITABLE(VisitResult<void>);
+	};
+	class VoidVisitor : public Visitor<VisitResult<void>, Known> {
+	public:
+		VisitResult<void> visit(Known&) override {
+			return {};
+		}
+	};
+	VoidUnknown vu;
+	VoidVisitor vv;
+	ASSERT_FALSE(vu.accept(vv));
+
+	struct Sentinel : public BaseVisitable<int, SentinelUnknownPolicy<-1>::Policy> {
+		MAKE_VISITABLE(int);
+	};
+	class EmptyVisitor : public Visitor<int> {};
+	Sentinel s;
+	EmptyVisitor e;
+	ASSERT_EQ(s.accept(e), -1);
+}
+
+TEST(VisitorTest, asyncVisitorTest) {
+	// each node reads its value from a file of a local store
+	struct FileNode : public AsyncVisitable<int> {
+		std::filesystem::path path;
+		explicit FileNode(std::filesystem::path path) : path(std::move(path)) {}
+		MAKE_VISITABLE(Task<int>);
+	};
+	struct Unreadable : public AsyncVisitable<int> {
+		MAKE_VISITABLE(Task<int>);
+	};
+	class LoadVisitor : public AsyncVisitor<int, FileNode> {
+	public:
+		EventLoop& loop;
+		int inFlight = 0, maxInFlight = 0;
+		explicit LoadVisitor(EventLoop& loop) : loop(loop) {}
+		Task<int> visit(FileNode& node) override {
+			maxInFlight = std::max(maxInFlight, ++inFlight);
+			// give the other visits a chance to start, as if waiting on I/O
+			co_await loop.schedule();
+			std::ifstream in(node.path);
+			int value = 0;
+			in >> value;
+			co_await loop.schedule();
+			--inFlight;
+			co_return value;
+		}
+	};
+
+	const auto dir = std::filesystem::temp_directory_path() / "SUtilitiesAsyncVisitorTest";
+	std::filesystem::create_directories(dir);
+	std::vector<std::unique_ptr<FileNode>> nodes;
+	for (int i = 0; i < 20; ++i) {
+		const auto path = dir / (std::to_string(i) + ".txt");
+		std::ofstream(path) << i;
+		nodes.push_back(std::make_unique<FileNode>(path));
+	}
+
+	EventLoop loop;
+	LoadVisitor visitor(loop);
+	ASSERT_EQ(loop.run(nodes[7]->acceptAsync(visitor)), 7);
+	const auto values = loop.run(acceptAllAsync(loop, nodes, visitor, 4));
+	ASSERT_EQ(values.size(), 20);
+	for (int i = 0; i < 20; ++i)
+		ASSERT_EQ(values[i], i);
+	ASSERT_EQ(visitor.maxInFlight, 4);
+	ASSERT_EQ(visitor.inFlight, 0);
+
+	// an unknown visit fails the batch once the started visits are done
+	Unreadable unreadable;
+	std::vector<AsyncVisitable<int>*> mixed = { nodes[0].get(), &unreadable, nodes[1].get() };
+	ASSERT_THROW(loop.run(acceptAllAsync(loop, mixed, visitor, 2)), UnknownVisitorException);
+	ASSERT_EQ(visitor.inFlight, 0);
+	auto task = unreadable.acceptAsync(visitor);
+	ASSERT_THROW(loop.run(std::move(task)), UnknownVisitorException);
+
+	auto sum = [](LoadVisitor& visitor, std::vector<std::unique_ptr<FileNode>>& nodes) -> Task<int> {
+		int total = 0;
+		for (auto& node : nodes)
+			total += co_await node->acceptAsync(visitor);
+		co_return total;
+	};
+	ASSERT_EQ(loop.run(sum(visitor, nodes)), 190);
+	std::filesystem::remove_all(dir);
+}
+
+namespace {
+	struct Drawing : public BaseVisitable<> {
+		MAKE_VISITABLE(void);
+	};
+	enum class Tint : std::uint8_t { red, green };
+	struct Disc : public Drawing {
+		double radius;
+		std::string_view name;
+		Tint color;
+		Disc(double radius, std::string_view name, Tint color) : radius(radius), name(name), color(color) {}
+		explicit Disc(BinaryReader& in) : radius(in.read<double>()), name(in.readString()), color(in.read<Tint>()) {}
+		void serialize(BinaryWriter& out) const {
+			out.write(radius);
+			out.write(name);
+			out.write(color);
+		}
+		MAKE_VISITABLE(void);
+	};
+	struct Layer : public Drawing {
+		std::span<std::int32_t> tags;
+		Drawing* first;
+		Drawing* second;
+		Layer(std::span<std::int32_t> tags, Drawing* first, Drawing* second) : tags(tags), first(first), second(second) {}
+		explicit Layer(BinaryReader& in) : tags(in.readArray<std::int32_t>()), first(in.readObject<Drawing>()),
+			second(in.readObject<Drawing>()) {}
+		void serialize(BinaryWriter& out) const {
+			out.writeArray<std::int32_t>(tags);
+			out.writeObject(first);
+			out.writeObject(second);
+		}
+		MAKE_VISITABLE(void);
+	};
+	/// an older version of Disc, which does not know about the color
+	struct OldDisc : public Drawing {
+		double radius;
+		explicit OldDisc(double radius) : radius(radius) {}
+		explicit OldDisc(BinaryReader& in) : radius(in.read<double>()) {}
+		void serialize(BinaryWriter& out) const {
+			out.write(radius);
+		}
+		MAKE_VISITABLE(void);
+	};
+	using Drawings = TL::TypeList<Disc, Layer>;
+}
+
+TEST(VisitorTest, serializationTest) {
+	std::int32_t tags[] = { 1, -2, 3 };
+	Disc a(1.5, "a", Tint::green), b(-2, "bee", Tint::red);
+	Layer inner(std::span(tags, 1), &b, nullptr);
+	Layer root(tags, &a, &inner);
+
+	std::array<std::byte, 256> buffer;
+	SerializeVisitor<Drawing, Drawings> serializer(buffer);
+	serializer.write(root);
+	ASSERT_FALSE(serializer.overflowed());
+	const auto size = serializer.size();
+	// the visitor writes the same record through accept()
+	std::array<std::byte, 256> visited;
+	SerializeVisitor<Drawing, Drawings> visitor(visited);
+	root.accept(visitor);
+	ASSERT_EQ(visitor.size(), size);
+	ASSERT_TRUE(std::equal(buffer.begin(), buffer.begin() + size, visited.begin()));
+
+	// scattered output is byte for byte the same
+	std::array<std::byte, 256> scattered;
+	std::array<IoVec, 3> segments = { IoVec{ scattered.data(), 3 }, IoVec{ scattered.data() + 3, 10 },
+		IoVec{ scattered.data() + 13, 243 } };
+	SerializeVisitor<Drawing, Drawings> gather(segments);
+	gather.write(root);
+	ASSERT_EQ(gather.size(), size);
+	ASSERT_TRUE(std::equal(buffer.begin(), buffer.begin() + size, scattered.begin()));
+
+	std::array<std::byte, 16> small;
+	SerializeVisitor<Drawing, Drawings> truncated(small);
+	truncated.write(root);
+	ASSERT_TRUE(truncated.overflowed());
+	ASSERT_EQ(truncated.size(), size);
+
+	Arena arena;
+	Deserializer<Drawing, Drawings> deserializer(std::span(buffer.data(), size), arena);
+	auto* copy = dynamic_cast<Layer*>(deserializer.read());
+	ASSERT_TRUE(deserializer.done());
+	ASSERT_NE(copy, nullptr);
+	ASSERT_EQ(copy->tags.size(), 3);
+	ASSERT_EQ(copy->tags[1], -2);
+	auto* copyA = dynamic_cast<Disc*>(copy->first);
+	ASSERT_NE(copyA, nullptr);
+	ASSERT_EQ(copyA->radius, 1.5);
+	ASSERT_EQ(copyA->name, "a");
+	ASSERT_EQ(copyA->color, Tint::green);
+	auto* copyInner = dynamic_cast<Layer*>(copy->second);
+	ASSERT_NE(copyInner, nullptr);
+	ASSERT_EQ(copyInner->second, nullptr);
+	ASSERT_EQ(static_cast<Disc*>(copyInner->first)->name, "bee");
+
+	// an older reader skips the fields it doesn't know
+	Deserializer<Drawing, TL::TypeList<OldDisc, Layer>> old(std::span(buffer.data(), size), arena);
+	auto* oldCopy = static_cast<Layer*>(old.read());
+	ASSERT_EQ(static_cast<OldDisc*>(oldCopy->first)->radius, 1.5);
+	ASSERT_EQ(static_cast<OldDisc*>(static_cast<Layer*>(oldCopy->second)->first)->radius, -2);
+	ASSERT_TRUE(old.done());
+
+	Deserializer<Drawing, Drawings> cut(std::span(buffer.data(), size - 1), arena);
+	ASSERT_THROW(cut.read(), SerializationException);
+	Deserializer<Drawing, TL::TypeList<Disc>> unknown(std::span(buffer.data(), size), arena);
+	ASSERT_THROW(unknown.read(), SerializationException);
+	OldDisc unlisted(1);
+	ASSERT_THROW(serializer.write(unlisted), SerializationException);
+
+	// nesting deeper than the limit is rejected instead of exhausting the stack
+	std::vector<Layer> chain;
+	chain.reserve(8);
+	chain.emplace_back(std::span<std::int32_t>(), nullptr, nullptr);
+	for (int i = 1; i < 8; ++i)
+		chain.emplace_back(std::span<std::int32_t>(), &chain.back(), nullptr);
+	SerializeVisitor<Drawing, Drawings> deep(buffer);
+	deep.write(chain.back());
+	ASSERT_FALSE(deep.overflowed());
+	Deserializer<Drawing, Drawings> shallow(std::span(buffer.data(), deep.size()), arena, 7);
+	ASSERT_THROW(shallow.read(), SerializationException);
+	Deserializer<Drawing, Drawings> enough(std::span(buffer.data(), deep.size()), arena, 8);
+	ASSERT_NE(enough.read(), nullptr);
+	ASSERT_TRUE(enough.done());
+}
+
 TEST(CastTest, castTest) {
 	narrow_cast<char>(100);
 	narrow_cast<short>(-5000);
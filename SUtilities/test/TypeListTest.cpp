@@ -1,6 +1,7 @@
 #include <TypeList.hpp>
 #include <gtest/gtest.h>
 #include <sstream>
+#include <vector>
 
 using namespace TL;
 
@@ -125,19 +126,36 @@ TEST(TypeListTest, sortTest) {
 	static_assert(!std::is_base_of_v<get_t<hOrd, 2>, get_t<hOrd, 3>>);
 	static_assert(!std::is_base_of_v<get_t<hOrd, 3>, get_t<hOrd, 4>>);
 }
-/// Warning: EXTREMELY Platform + Compiler DEPENDENT
 TEST(TypeListTest, iterationTest) {
-	std::stringstream ss;
+	std::stringstream ss, expected;
 	for_each<list>([&ss](const std::type_info& info) {
 		ss << info.name() << " ";
 	});
-	ASSERT_EQ(ss.str(), "int char short long __int64 ");
+	// type names are platform + compiler dependent
+	expected << typeid(int).name() << " " << typeid(char).name() << " " << typeid(short).name() << " "
+		<< typeid(long).name() << " " << typeid(long long).name() << " ";
+	ASSERT_EQ(ss.str(), expected.str());
 	using rev = reverse_t<list>;
 	ss.str("");
+	expected.str("");
 	for_each<rev>([&ss](const std::type_info& info) {
 		ss << info.name() << " ";
 	});
-	ASSERT_EQ(ss.str(), "__int64 long short char int ");
+	expected << typeid(long long).name() << " " << typeid(long).name() << " " << typeid(short).name() << " "
+		<< typeid(char).name() << " " << typeid(int).name() << " ";
+	ASSERT_EQ(ss.str(), expected.str());
+}
+TEST(TypeListTest, typeIdTest) {
+	static_assert(getId<list>(1) == SUtil::typeId<char>());
+	static_assert(getId<list>(4) != getId<list>(3));
+	ASSERT_EQ(getId<list>(0).name(), "int");
+	std::vector<SUtil::TypeId> ids;
+	for_each<reverse_t<list>>([&ids](SUtil::TypeId id) {
+		ids.push_back(id);
+	});
+	// type names are compiler dependent, but the ids are not
+	ASSERT_EQ(ids, (std::vector{ SUtil::typeId<long long>(), SUtil::typeId<long>(), SUtil::typeId<short>(),
+		SUtil::typeId<char>(), SUtil::typeId<int>() }));
 }
 
 int main(int argc, char** argv) {
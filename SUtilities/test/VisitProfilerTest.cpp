@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <Visitable.hpp>
+#include <Visitor.hpp>
+#include <VisitProfiler.hpp>
+#include <sstream>
+#include <thread>
+
+using namespace SUtil;
+
+static_assert(SUTIL_PROFILE_VISITS, "VisitProfilerTest must be built with SUTIL_PROFILE_VISITS=1");
+
+namespace {
+	struct Cheap : public BaseVisitable<int> {
+		MAKE_VISITABLE(int);
+	};
+	struct Expensive : public BaseVisitable<int> {
+		MAKE_VISITABLE(int);
+	};
+	class ProfiledVisitor : public Visitor<int, Cheap, Expensive> {
+	public:
+		int visit(Cheap&) override {
+			return 1;
+		}
+		int visit(Expensive&) override {
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+			return 2;
+		}
+	};
+}
+
+TEST(VisitProfilerTest, profileTest) {
+	setVisitProfileReport(false);
+	setVisitProfileSampling(1);
+	resetVisitProfile();
+	Cheap c;
+	Expensive e;
+	ProfiledVisitor v;
+	for (int i = 0; i < 100; ++i)
+		c.accept(v);
+	for (int i = 0; i < 10; ++i)
+		e.accept(v);
+	// counters of exited threads are kept
+	std::thread([&]() {
+		for (int i = 0; i < 5; ++i)
+			e.accept(v);
+	}).join();
+
+	const auto profile = visitProfile();
+	ASSERT_EQ(profile.size(), 2);
+	ASSERT_EQ(profile[0].visited, typeId<Expensive>().name());
+	ASSERT_EQ(profile[0].calls, 15);
+	ASSERT_EQ(profile[0].samples, 15);
+	ASSERT_GE(profile[0].meanNanos(), 200'000.0);
+	ASSERT_GE(profile[0].percentileNanos(0.5), 200'000);
+	ASSERT_NE(profile[0].visitor.find("ProfiledVisitor"), std::string::npos);
+	ASSERT_EQ(profile[1].visited, typeId<Cheap>().name());
+	ASSERT_EQ(profile[1].calls, 100);
+
+	std::stringstream ss;
+	printVisitProfile(ss, profile);
+	ASSERT_NE(ss.str().find("Expensive"), std::string::npos);
+
+	setVisitProfileSampling(10);
+	resetVisitProfile();
+	for (int i = 0; i < 100; ++i)
+		c.accept(v);
+	const auto sampled = visitProfile();
+	ASSERT_EQ(sampled.size(), 1);
+	ASSERT_EQ(sampled[0].calls, 100);
+	ASSERT_GE(sampled[0].samples, 9);
+	ASSERT_LE(sampled[0].samples, 11);
+}
+
+int main(int argc, char** argv) {
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}